@@ -0,0 +1,112 @@
+# audiocodec.py -- coded audio blobs (sampletype 2) for o2audioio peers
+#
+# Roger B. Dannenberg
+# Oct, 2026
+#
+"""
+Encode and decode the lossless predictive coding used by o2audioio
+when sampletype is 2 (see arco/src/audioblob.h for the format).
+Samples are lists of int16 values in blob order: each block of BL
+frames is chans consecutive runs of BL samples.
+
+    samples = blob_decode(data, chans)  # data is bytes
+    data = blob_encode(samples, chans)
+
+Segments are byte-aligned, so the decoder runs until data is used up,
+and frames is len(samples) // chans.
+"""
+
+import struct
+
+BL = 32
+
+
+def _residual(s, i, order):
+    if order == 0:
+        return s[i]
+    if order == 1:
+        return s[i] - s[i - 1]
+    return s[i] - 2 * s[i - 1] + s[i - 2]
+
+
+def blob_encode(samples, chans):
+    nseg = len(samples) // BL
+    history = [0] * (2 * chans)
+    out = bytearray()
+    for seg in range(nseg):
+        c = seg % chans
+        x = samples[seg * BL : (seg + 1) * BL]
+        s = history[2 * c : 2 * c + 2] + list(x)
+        history[2 * c : 2 * c + 2] = s[BL : BL + 2]
+        totals = [sum(abs(_residual(s, i, o)) for i in range(2, BL + 2))
+                  for o in range(3)]
+        order = totals.index(min(totals))
+        u = []
+        for i in range(2, BL + 2):
+            e = _residual(s, i, order)
+            u.append(e << 1 if e >= 0 else (-e << 1) - 1)
+        k = 0
+        while k < 30 and (BL << k) < sum(u):
+            k += 1
+        size = BL * (k + 1) + sum(v >> k for v in u)
+        if size >= BL * 16:  # store the samples
+            out.append((order << 5) | 31)
+            out += struct.pack(f'>{BL}h', *x)
+            continue
+        out.append((order << 5) | k)
+        bits = []
+        for v in u:
+            bits.append('0' * (v >> k) + '1')
+            if k > 0:
+                bits.append(format(v & ((1 << k) - 1), f'0{k}b'))
+        bits = ''.join(bits)
+        bits += '0' * (-len(bits) % 8)
+        out += int(bits, 2).to_bytes(len(bits) // 8, 'big')
+    return bytes(out)
+
+
+def blob_decode(data, chans):
+    """return decoded samples, or None if data is not a valid coded blob"""
+    history = [0] * (2 * chans)
+    samples = []
+    pos = 0
+    seg = 0
+    while pos < len(data):
+        c = seg % chans
+        seg += 1
+        order = data[pos] >> 5
+        k = data[pos] & 31
+        pos += 1
+        if order > 2:
+            return None
+        if k == 31:
+            if len(data) - pos < BL * 2:
+                return None
+            x = list(struct.unpack(f'>{BL}h', data[pos : pos + BL * 2]))
+            pos += BL * 2
+        else:
+            bits = ''.join(format(b, '08b') for b in data[pos:])
+            bit = 0
+            s1, s2 = history[2 * c + 1], history[2 * c]
+            x = []
+            for i in range(BL):
+                one = bits.find('1', bit)
+                if one < 0 or one + 1 + k > len(bits):
+                    return None
+                q = one - bit
+                r = int(bits[one + 1 : one + 1 + k], 2) if k > 0 else 0
+                bit = one + 1 + k
+                v = (q << k) | r
+                e = -(v >> 1) - 1 if v & 1 else v >> 1
+                p = 0 if order == 0 else (s1 if order == 1 else 2 * s1 - s2)
+                v = p + e
+                if v < -32768 or v > 32767:
+                    return None
+                x.append(v)
+                s2, s1 = s1, v
+            pos += (bit + 7) // 8
+        history[2 * c : 2 * c + 2] = x[BL - 2 : BL]
+        samples += x
+    if seg % chans != 0:
+        return None
+    return samples
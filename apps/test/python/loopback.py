@@ -70,7 +70,8 @@ def prep_handler(address, types, info):
     prepped = True
     print("Got prep message: id", id, "inchans", inchans, \
           "outchans", outchans,  "samplerate", samplerate, \
-          "sampletype", "float" if sampletype == 1 else "16-bit")
+          "sampletype", ["16-bit", "float", "coded 16-bit"][sampletype & 3],
+          "(little-endian)" if sampletype & 4 else "")
     # ignoring info because we will just return whatever data we get
 
 
@@ -29,6 +29,7 @@ from o2litepy import O2lite, O2blob
 import time
 import struct
 import math
+import audiocodec
 
 ENSEMBLE = "arco"
 BL = 32
@@ -43,22 +44,23 @@ o2audioio_id = -1
 inchans = 0
 outchans = 0
 sampletype = 0
+endian = '>'  # big-endian unless sampletype includes 4 (little-endian)
 samplerate = 44100.0
 prepped = False
 
 
 def blob_get_int16(blob):
-    return struct.unpack(f'>{blob.size // 2}h', blob.data)
+    return struct.unpack(f'{endian}{blob.size // 2}h', blob.data)
 
 def blob_get_float(blob):
-    return struct.unpack(f'>{blob.size // 4}f', blob.data)
+    return struct.unpack(f'{endian}{blob.size // 4}f', blob.data)
 
 def blob_put_int16(blob, x):
-    blob.data = struct.pack(f'>{len(x)}h', *x)
+    blob.data = struct.pack(f'{endian}{len(x)}h', *x)
     blob.size = len(blob.data)
 
 def blob_put_float(blob, x):
-    blob.data = struct.pack(f'>{len(x)}f', *x)
+    blob.data = struct.pack(f'{endian}{len(x)}f', *x)
     blob.size = len(blob.data)
 
 
@@ -77,17 +79,19 @@ class Audioblob:
 
             
 def prep_handler(address, types, info):
-    global inchans, outchans, samplerate, sampletype, \
+    global inchans, outchans, samplerate, sampletype, endian, \
            o2audioio_id, prepped
     o2audioio_id = o2lite.get_int32()
     inchans = o2lite.get_int32()
     outchans = o2lite.get_int32()
     samplerate = o2lite.get_float()
     sampletype = o2lite.get_int32()
+    endian = '<' if sampletype & 4 else '>'
+    sampletype &= 3
     prepped = True
     print("Got prep message: id", id, "inchans", inchans, \
           "outchans", outchans,  "samplerate", samplerate, \
-          "sampletype", "float" if sampletype == 1 else "16-bit")
+          "sampletype", ["16-bit", "float", "coded 16-bit"][sampletype])
     # ignoring info because we will just return whatever data we get
 
 
@@ -169,6 +173,16 @@ def data_handler(address, types, info):
         samples = process_audio([s * 3.0518509476e-5 for s in samples])
         blob_put_int16(data, [math.trunc((32767 * s + 32768.5) - 32768) \
                                      for s in  samples])
+    elif sampletype == 2:  # coded int16
+        samples = audiocodec.blob_decode(data.data, inchans)
+        if samples is None:
+            print("Invalid coded blob, frames", frames)
+            return
+        samples = process_audio([s * 3.0518509476e-5 for s in samples])
+        data.data = audiocodec.blob_encode(
+                [math.trunc((32767 * s + 32768.5) - 32768) for s in samples],
+                outchans)
+        data.size = len(data.data)
     else:
         samples = blob_get_float(data)
         samples = process_audio(samples)
@@ -33,6 +33,7 @@ ChordDetector::ChordDetector()
 {
 	bias = 1.06;
 	makeChordProfiles();
+	makeChordWeights();
 }
 
 //=======================================================================
@@ -200,67 +201,42 @@ void ChordDetector::compareAlgos(double a_fifth, double a_third,
 void ChordDetector::calculateChordScores (double chord[NUM_CHORDS],
                                           double chromagram[12])
 {
-    int j;
-    // major chords
-    for (j = 0; j < 12; j++)
+    // same as calculateChordScore() for each chord, in the same order
+    // of operations, but with chords in the inner loop
+    for (int j = 0; j < NUM_CHORDS; j++)
     {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 3);
+        chord[j] = 0;
     }
-    
-    // minor chords
-    for (j = 12; j < 24; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 3);
-    }
-    
-    // diminished 5th chords
-    for (j = 24; j < 36; j++)
+    for (int i = 0; i < 12; i++)
     {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 3);
-    }
-    
-    // augmented 5th chords
-    for (j = 36; j < 48; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 3);
-    }
-    
-    // sus2 chords
-    for (j = 48; j < 60; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], 1, 3);
-    }
-    
-    // sus4 chords
-    for (j = 60; j < 72; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], 1, 3);
-    }
-    
-    // major 7th chords
-    for (j = 72; j < 84; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], 1, 4);
+        double energy = chromagram[i] * chromagram[i];
+        const double *weights = chordWeights[i];
+        for (int j = 0; j < NUM_CHORDS; j++)
+        {
+            chord[j] += weights[j] * energy;
+        }
     }
-    
-    // minor 7th chords
-    for (j = 84; j < 96; j++)
+    for (int j = 0; j < NUM_CHORDS; j++)
     {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 4);
+        chord[j] = sqrt (chord[j]) / chordDivisors[j];
     }
+}
 
-    // dominant 7th chords
-    for (j = 96; j < 108; j++)
-    {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 4);
-    }
-    
-    // half-diminished chords
-    for (j = 108; j < 120; j++)
+//=======================================================================
+void ChordDetector::makeChordWeights()
+{
+    for (int j = 0; j < NUM_CHORDS; j++)
     {
-        chord[j] = calculateChordScore (chromagram, chordProfiles[j], bias, 4);
+        for (int i = 0; i < 12; i++)
+        {
+            chordWeights[i][j] = 1 - chordProfiles[j][i];
+        }
+        // triads (j < 72) have 3 notes; sus2, sus4 and major 7th
+        // chords (48 <= j < 84) do not use bias:
+        double N = (j < 72 ? 3 : 4);
+        double biasToUse = ((j >= 48 && j < 84) ? 1 : bias);
+        chordDivisors[j] = (12 - N) * biasToUse;
     }
-    
 }
 
 //=======================================================================
@@ -388,11 +364,12 @@ void ChordDetector::softmaxEntropyConfidence (double chord[NUM_CHORDS],
     double sum_exp = 0.0;
     
     for (int i = 0; i < NUM_CHORDS; i++) {
-        sum_exp += std::exp(newScores[i] - max_score);
+        probabilities[i] = std::exp(newScores[i] - max_score);
+        sum_exp += probabilities[i];
     }
     
     for (int i = 0; i < NUM_CHORDS; i++) {
-        probabilities[i] = std::exp(newScores[i] - max_score) / sum_exp;
+        probabilities[i] /= sum_exp;
     }
     
     // Entropy
@@ -71,6 +71,7 @@ public:
 	
 private:
 	void makeChordProfiles();
+	void makeChordWeights();
 	void classifyChromagram();
 	double calculateChordScore (double* chroma, double* chordProfile,
                                     double biasToUse, double N);
@@ -103,6 +104,13 @@ private:
 	double chordProfiles[NUM_CHORDS][12];
 	double chord[NUM_CHORDS];
 	double bias;
+
+    /** calculateChordScore() for all chords at once: chordWeights[i][j]
+     * is 1 - chordProfiles[j][i], so that the loop over chords is
+     * innermost and vectorizes, and chordDivisors[j] is (12 - N) * bias
+     * for chord j */
+    double chordWeights[12][NUM_CHORDS];
+    double chordDivisors[NUM_CHORDS];
 };
 
 #endif
@@ -37,8 +37,8 @@ Chromagram::Chromagram (int frameSize, int fs) :
     // set up FFT
     setupFFT();
     
-    // set buffer size
-    buffer = O2_MALLOCNT(bufferSize, float);
+    // set buffer size (zero, so the sliding DFT of it is zero)
+    buffer = O2_CALLOCNT(bufferSize, float);
     
     // setup chromagram vector
     chromagram = O2_MALLOCNT(12, float);
@@ -55,7 +55,17 @@ Chromagram::Chromagram (int frameSize, int fs) :
     // make window function
     makeHammingWindow();
     
-    // set sampling frequency
+    // set chroma calculation interval (in samples at the input audio sampling frequency)
+    chromaCalculationInterval = 4096;
+    
+    // set sampling frequency (and make the kernel)
+    kernel = NULL;
+    slidingBins = NULL;
+    slidingIndex = NULL;
+    slidingRe = NULL;
+    slidingIm = NULL;
+    twiddleRe = NULL;
+    twiddleIm = NULL;
     setSamplingFrequency (fs);
     
     // set input audio frame size
@@ -64,9 +74,6 @@ Chromagram::Chromagram (int frameSize, int fs) :
     // initialise num samples counter
     numSamplesSinceLastCalculation = 0;
     
-    // set chroma calculation interval (in samples at the input audio sampling frequency)
-    chromaCalculationInterval = 4096;
-    
     // initialise chroma ready variable
     chromaReady = false;
     
@@ -88,6 +95,13 @@ Chromagram::~Chromagram()
     O2_FREE(magnitudeSpectrum);
     O2_FREE(downsampledInputAudioFrame);
     O2_FREE(chromagram);
+    O2_FREE(kernel);
+    O2_FREE(slidingBins);
+    O2_FREE(slidingIndex);
+    O2_FREE(slidingRe);
+    O2_FREE(slidingIm);
+    O2_FREE(twiddleRe);
+    O2_FREE(twiddleIm);
     // ------------------------------------
 #ifdef USE_FFTW
     // destroy fft plan
@@ -120,39 +134,28 @@ void Chromagram::processAudioFrame (float* inputAudioFrame)
     // downsample the input audio frame by 4
     downSampleFrame(inputAudioFrame);
     
-    int n = 0;
-    
-    // add new samples to buffer
-    for (int i = bufferIndex; i < bufferIndex + downSampledAudioFrameSize; i++)
+    // add new samples to buffer, replacing the oldest ones
+    for (int n = 0; n < downSampledAudioFrameSize; n++)
     {
-        buffer[i] = downsampledInputAudioFrame[n];
-        n++;
+        float oldSample = buffer[bufferIndex];
+        buffer[bufferIndex] = downsampledInputAudioFrame[n];
+        bufferIndex = (bufferIndex + 1) & (bufferSize - 1);
+        
+        if (useSlidingDFT)
+        {
+            slideBins (downsampledInputAudioFrame[n], oldSample);
+        }
     }
     
     // add number of samples from calculation
     numSamplesSinceLastCalculation += inputAudioFrameSize;
     
-    bufferIndex += downSampledAudioFrameSize;
-    
     // if we have had enough samples
     if (numSamplesSinceLastCalculation >= chromaCalculationInterval)
     {
         // calculate the chromagram
         calculateChromagram();
         
-        // If buffer cannot take one more frame, shift it left by
-        // downSampledCalcInterval and update bufferIndex
-        int downSampledCalcInterval = chromaCalculationInterval / 4;
-        if (bufferIndex + downSampledAudioFrameSize >= bufferSize) {
-            
-            for (int i = 0; i < bufferSize - downSampledCalcInterval; i++)
-            {
-                buffer[i] = buffer[i + downSampledCalcInterval];
-            }
-            
-            bufferIndex -= downSampledCalcInterval;
-        }
-        
         // reset num samples counter
         numSamplesSinceLastCalculation = 0;
     }
@@ -171,6 +174,8 @@ void Chromagram::setInputAudioFrameSize (int frameSize)
 void Chromagram::setSamplingFrequency (int fs)
 {
     samplingFrequency = fs;
+    setupKernel();
+    chooseMethod();
 }
 
 //============================================================================
@@ -183,6 +188,29 @@ void Chromagram::setChromaCalculationInterval (int numSamples)
         return;
     }
     chromaCalculationInterval = numSamples;
+    chooseMethod();
+}
+
+//============================================================================
+void Chromagram::chooseMethod()
+{
+    // compare the sliding DFT update of numSlidingBins complex bins per
+    // (downsampled) sample to an FFT of (bufferSize / 2) log2(bufferSize)
+    // complex butterflies per calculation:
+    double slidingCost = (chromaCalculationInterval / 4.0) * numSlidingBins;
+    double fftCost = (bufferSize / 2.0) * log2 ((double) bufferSize);
+    bool sliding = (slidingCost < fftCost);
+    if (sliding && !useSlidingDFT)
+    {
+        // restart the sliding DFT; samples now in buffer are not in it
+        for (int j = 0; j < numSlidingBins; j++)
+        {
+            slidingRe[j] = 0;
+            slidingIm[j] = 0;
+        }
+        slidingWarmup = bufferSize;
+    }
+    useSlidingDFT = sliding;
 }
 
 //============================================================================
@@ -228,12 +256,115 @@ void Chromagram::setupFFT()
 
 
 //============================================================================
-void Chromagram::calculateChromagram()
+void Chromagram::setupKernel()
 {
-    calculateMagnitudeSpectrum();
-    
+    if (kernel)  // free the tables for the previous sampling frequency
+    {
+        O2_FREE(kernel);
+        O2_FREE(slidingBins);
+        O2_FREE(slidingIndex);
+        O2_FREE(slidingRe);
+        O2_FREE(slidingIm);
+        O2_FREE(twiddleRe);
+        O2_FREE(twiddleIm);
+    }
+
     double divisorRatio = (((double) samplingFrequency) / 4.0) / ((double)bufferSize);
+    int numBins = (bufferSize / 2) + 1;
+    
+    numKernelRanges = 12 * numOctaves * numHarmonics;
+    kernel = O2_MALLOCNT(numKernelRanges, KernelRange);
+    slidingIndex = O2_MALLOCNT(numBins, int);
+    for (int k = 0; k < numBins; k++)
+    {
+        slidingIndex[k] = -1;
+    }
     
+    // the order of ranges is the order of use in calculateChromagram()
+    int r = 0;
+    for (int n = 0; n < 12; n++)
+    {
+        for (int octave = 1; octave <= numOctaves; octave++)
+        {
+            for (int harmonic = 1; harmonic <= numHarmonics; harmonic++)
+            {
+                int centerBin = round((noteFrequencies[n] * octave * harmonic) /
+                                      divisorRatio);
+                KernelRange &range = kernel[r++];
+                range.minBin = MAX(centerBin - (numBinsToSearch * harmonic), 1);
+                range.maxBin = MIN(centerBin + (numBinsToSearch * harmonic),
+                                   numBins - 1);
+                range.harmonic = harmonic;
+                // the window needs the neighbors of each bin:
+                for (int k = range.minBin - 1; k <= range.maxBin; k++)
+                {
+                    slidingIndex[k] = 0;
+                }
+            }
+        }
+    }
+    
+    numSlidingBins = 0;
+    for (int k = 0; k < numBins; k++)
+    {
+        if (slidingIndex[k] == 0)
+        {
+            numSlidingBins++;
+        }
+    }
+    slidingBins = O2_MALLOCNT(numSlidingBins, int);
+    slidingRe = O2_CALLOCNT(numSlidingBins, double);
+    slidingIm = O2_CALLOCNT(numSlidingBins, double);
+    twiddleRe = O2_MALLOCNT(numSlidingBins, double);
+    twiddleIm = O2_MALLOCNT(numSlidingBins, double);
+    int j = 0;
+    for (int k = 0; k < numBins; k++)
+    {
+        if (slidingIndex[k] == 0)
+        {
+            slidingIndex[k] = j;
+            slidingBins[j] = k;
+            twiddleRe[j] = cos (2 * M_PI * k / bufferSize);
+            twiddleIm[j] = sin (2 * M_PI * k / bufferSize);
+            j++;
+        }
+    }
+    // the sliding DFT (if used) starts over
+    useSlidingDFT = false;
+}
+
+//============================================================================
+void Chromagram::slideBins (float newSample, float oldSample)
+{
+    // X[k] = exp(2 pi i k / N) * (X[k] + newest - oldest) slides the
+    // DFT of the last N samples by one sample
+    double delta = newSample;
+    if (slidingWarmup > 0)
+    {
+        slidingWarmup--;  // oldSample is not in the DFT
+    } else {
+        delta -= oldSample;
+    }
+    for (int j = 0; j < numSlidingBins; j++)
+    {
+        double re = slidingRe[j] + delta;
+        double im = slidingIm[j];
+        slidingRe[j] = re * twiddleRe[j] - im * twiddleIm[j];
+        slidingIm[j] = re * twiddleIm[j] + im * twiddleRe[j];
+    }
+}
+
+//============================================================================
+void Chromagram::calculateChromagram()
+{
+    if (useSlidingDFT && slidingWarmup == 0)
+    {
+        calculateSlidingMagnitudes();
+    } else {
+        calculateMagnitudeSpectrum();
+    }
+    
+    const KernelRange* range = kernel;
     for (int n = 0; n < 12; n++)
     {
         double chromaSum = 0.0;
@@ -244,14 +375,9 @@ void Chromagram::calculateChromagram()
             
             for (int harmonic = 1; harmonic <= numHarmonics; harmonic++)
             {
-                int centerBin = round((noteFrequencies[n] * octave * harmonic) /
-                                      divisorRatio);
-                int minBin = centerBin - (numBinsToSearch * harmonic);
-                int maxBin = centerBin + (numBinsToSearch * harmonic);
-                
                 double maxVal = 0.0;
                 
-                for (int k = minBin; k < maxBin; k++)
+                for (int k = range->minBin; k < range->maxBin; k++)
                 {
                     if (magnitudeSpectrum[k] > maxVal)
                     {
@@ -260,6 +386,7 @@ void Chromagram::calculateChromagram()
                 }
             
                 noteSum += (maxVal / (double) harmonic);
+                range++;
             }
             
             chromaSum += noteSum;
@@ -271,6 +398,25 @@ void Chromagram::calculateChromagram()
     chromaReady = true;
 }
 
+//============================================================================
+void Chromagram::calculateSlidingMagnitudes()
+{
+    // Apply the Hamming window (0.54 - 0.46 cos(2 pi n / N)) in the
+    // frequency domain: 0.54 X[k] - 0.23 (X[k - 1] + X[k + 1])
+    for (int r = 0; r < numKernelRanges; r++)
+    {
+        for (int k = kernel[r].minBin; k < kernel[r].maxBin; k++)
+        {
+            int j = slidingIndex[k];
+            int jl = slidingIndex[k - 1];
+            int jh = slidingIndex[k + 1];
+            double re = 0.54 * slidingRe[j] - 0.23 * (slidingRe[jl] + slidingRe[jh]);
+            double im = 0.54 * slidingIm[j] - 0.23 * (slidingIm[jl] + slidingIm[jh]);
+            magnitudeSpectrum[k] = sqrt (re * re + im * im);
+        }
+    }
+}
+
 //============================================================================
 void Chromagram::calculateMagnitudeSpectrum()
 {
@@ -283,9 +429,10 @@ void Chromagram::calculateMagnitudeSpectrum()
     // -----------------------------------------------
     int i = 0;
     
+    // buffer is a ring; bufferIndex is the oldest sample
     for (int i = 0; i < bufferSize; i++)
     {
-        complexIn[i][0] = buffer[i] * window[i];
+        complexIn[i][0] = buffer[(bufferIndex + i) & (bufferSize - 1)] * window[i];
         complexIn[i][1] = 0.0;
     }
     
@@ -306,9 +453,10 @@ void Chromagram::calculateMagnitudeSpectrum()
     // -----------------------------------------------
     int i = 0;
     
+    // buffer is a ring; bufferIndex is the oldest sample
     for (int i = 0;i < bufferSize; i++)
     {
-        fftIn[i].r = buffer[i] * window[i];
+        fftIn[i].r = buffer[(bufferIndex + i) & (bufferSize - 1)] * window[i];
         fftIn[i].i = 0.0;
     }
     
@@ -329,8 +477,14 @@ void Chromagram::calculateMagnitudeSpectrum()
     // -----------------------------------------------
     int i = 0;
     
-    for (int i = 0; i < bufferSize; i++) {
-        fft_data[i] = buffer[i] * window[i];
+    // buffer is a ring; bufferIndex is the oldest sample, so copy
+    // in two parts to unwrap it
+    int n = bufferSize - bufferIndex;
+    for (int i = 0; i < n; i++) {
+        fft_data[i] = buffer[bufferIndex + i] * window[i];
+    }
+    for (int i = n; i < bufferSize; i++) {
+        fft_data[i] = buffer[i - n] * window[i];
     }
     
     rffts(fft_data, log2_fft_size, 1);
@@ -351,8 +505,6 @@ void Chromagram::calculateMagnitudeSpectrum()
 //============================================================================
 void Chromagram::downSampleFrame (float* inputAudioFrame)
 {
-    float* filteredFrame = O2_MALLOCNT(inputAudioFrameSize, float);
-    
     float b0,b1,b2,a1,a2;
     
     b0 = 0.2929;
@@ -361,22 +513,21 @@ void Chromagram::downSampleFrame (float* inputAudioFrame)
     a1 = -0.0000;
     a2 = 0.1716;
     
+    // filter, keeping every 4th output
     for (int i = 0; i < inputAudioFrameSize; i++)
     {
-        filteredFrame[i] = inputAudioFrame[i] * b0 + x_1 * b1 + x_2 * b2 - y_1 * a1 - y_2 * a2;
+        float y = inputAudioFrame[i] * b0 + x_1 * b1 + x_2 * b2 - y_1 * a1 - y_2 * a2;
+        
+        if ((i & 3) == 0)
+        {
+            downsampledInputAudioFrame[i >> 2] = y;
+        }
         
         x_2 = x_1;
         x_1 = inputAudioFrame[i];
         y_2 = y_1;
-        y_1 = filteredFrame[i];
+        y_1 = y;
     }
-    
-    for (int i = 0; i < inputAudioFrameSize / 4; i++)
-    {
-        downsampledInputAudioFrame[i] = filteredFrame[i * 4];
-    }
-    
-    O2_FREE(filteredFrame);
 }
 
 //============================================================================
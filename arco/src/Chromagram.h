@@ -83,7 +83,9 @@ public:
      * will be calculated, specified in the number of samples at the
      * audio sampling frequency
      * @param numSamples the number of samples that the algorithm will
-     *     receive before calculating a new chromagram
+     *     receive before calculating a new chromagram. Short intervals
+     *     switch from an FFT per chromagram to a sliding DFT of only
+     *     the bins that are used
      */
     void setChromaCalculationInterval (int numSamples);
     
@@ -99,12 +101,24 @@ public:
 private:
     
     void setupFFT();
+    void setupKernel();
+    void chooseMethod();
     void calculateChromagram();
     void calculateMagnitudeSpectrum();
+    void calculateSlidingMagnitudes();
+    void slideBins (float newSample, float oldSample);
 	void downSampleFrame (float* inputAudioFrame);
     void makeHammingWindow();
     double round (double val);
     
+    /** The bins searched for one harmonic of one note in one octave */
+    struct KernelRange
+    {
+        int minBin;
+        int maxBin;    // last bin + 1
+        int harmonic;
+    };
+    
     float* window;
     float* buffer;
     float* magnitudeSpectrum;
@@ -115,7 +129,8 @@ private:
     double noteFrequencies[12];
     
     int bufferSize;
-    int bufferIndex; // Where to add new samples in buffer
+    int bufferIndex; // Where to add new samples in buffer, a ring
+                     // buffer, so this is also the oldest sample
     int samplingFrequency;
     int inputAudioFrameSize;
     int downSampledAudioFrameSize;
@@ -129,6 +144,24 @@ private:
     //  downsampling low pass filter states
     float x_1, x_2, y_1, y_2;
 
+    // The chromagram only uses magnitudes of the bins in kernel, a few
+    // hundred of the bufferSize / 2 + 1 bins. When chroma are
+    // calculated often, it is cheaper to keep a sliding DFT of just
+    // those bins (and their neighbors, to apply the window in the
+    // frequency domain) than to FFT the whole buffer at every hop.
+    KernelRange* kernel;
+    int numKernelRanges;
+    int* slidingBins;     // bins of the sliding DFT
+    int* slidingIndex;    // slidingIndex[bin] is the index of bin in
+                          //     slidingBins, or -1
+    int numSlidingBins;
+    double* slidingRe;    // DFT of buffer (oldest sample first)
+    double* slidingIm;
+    double* twiddleRe;    // exp(2 pi i bin / bufferSize)
+    double* twiddleIm;
+    bool useSlidingDFT;
+    int slidingWarmup;    // samples in buffer older than the sliding DFT
+
 #ifdef USE_FFTW
     fftw_plan p;
 	fftw_complex* complexOut;
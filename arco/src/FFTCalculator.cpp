@@ -76,7 +76,7 @@ FFTCalculator::~FFTCalculator()
 //==================================================================================
 void FFTCalculator::calculateFFTFrequencies()
 {
-    for (int i = 1; i < (bufferSize / 2) + 1; i++) {
+    for (int i = 0; i < (bufferSize / 2) + 1; i++) {
         FFTfrequencies[i] = samplingFrequency * i / bufferSize;
     }
 }
@@ -5,6 +5,7 @@
 
 #include "assert.h"
 #include <string.h>
+#include <stddef.h>
 #include "o2internal.h"
 #include "sharedmemclient.h"
 #include "arcotypes.h"
@@ -13,11 +14,20 @@
 #include "ugenid.h"
 #include "audioio.h"
 #include "ugen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
 #include "audioblob.h"
 
 void blob_byteswap(char *data, int frames, int chans, bool floattype)
 {
 #if IS_LITTLE_ENDIAN
+    blob_swap(data, frames, chans, floattype);
+#endif
+}
+
+
+void blob_swap(char *data, int frames, int chans, bool floattype)
+{
     int n = frames * chans;
     if (floattype) {
         for (int i = 0; i < n; i++) {
@@ -34,5 +44,240 @@ void blob_byteswap(char *data, int frames, int chans, bool floattype)
             *loc = swap16(f);
         }
     }
-#endif
+}
+
+
+// switch to writing samples directly into messages to address (see
+// audioblob.h). Samples are big-endian unless little is true.
+void Audioblob::use_messages(const char *address, int32_t id, bool little)
+{
+    if (chans <= 0 || header) {
+        return;
+    }
+    O2_FREE(blob);
+    blob = NULL;
+    data = NULL;
+    swap = (little != IS_LITTLE_ENDIAN);
+    // message is the O2message fields, address padded to a word,
+    // ",ithb" padded to a word, then arguments id (4), when (8),
+    // framecount (8) and blob size (4), then samples:
+    int addr_len = ((int) strlen(address) + 4) & ~3;
+    int types_offset = (int) (offsetof(O2message, data) +
+                              offsetof(O2msg_data, address)) + addr_len;
+    header_len = types_offset + 8 + 24;
+    header = O2_MALLOCNT(header_len, char);
+    memset(header, 0, header_len);
+    O2message_ptr m = (O2message_ptr) header;
+    m->data.misc = O2_TCP_FLAG;  // deliver reliably, like o2sm_send_finish
+    strcpy(m->data.address, address);
+    memcpy(header + types_offset, ",ithb", 5);
+    char *args = header + types_offset + 8;
+    int32_t size = frames * chans * 2 * (floattype + 1);
+    memcpy(args, &id, 4);
+    memcpy(args + 20, &size, 4);
+    msg_len = header_len + size;
+    pool = bufferpool_pow2((msg_len + sizeof(Sample) - 1) / sizeof(Sample));
+    if (pool) {
+        pool->reserve(AUDIOBLOB_RESERVE);
+    }
+}
+
+
+// get a message to fill, normally from pool
+void Audioblob::start_message()
+{
+    if (!msg) {
+        msg = pool ? (O2message_ptr) pool->get() : NULL;
+        if (!msg) {  // pool is empty (or msg_len is huge)
+            msg = (O2message_ptr) O2_MALLOC(msg_len);
+        }
+        memcpy(msg, header, header_len);
+    }
+    data = ((char *) msg) + header_len;
+}
+
+
+// complete the message, which the caller must send or free
+O2message_ptr Audioblob::finish_message(double when, int64_t framecount)
+{
+    O2message_ptr m = msg;
+    char *args = ((char *) m) + header_len - 24;
+    memcpy(args + 4, &when, 8);
+    memcpy(args + 12, &framecount, 8);
+    m->data.length = (int32_t) (((char *) m) + msg_len -
+                                ((char *) &(m->data.misc)));
+    msg = NULL;
+    data = NULL;
+    clear();
+    return m;
+}
+
+
+// bit writer and reader for coded blobs, most significant bit first:
+struct Blob_bits {
+    uint8_t *ptr;
+    uint32_t acc;  // pending bits, right-aligned
+    int count;     // number of pending bits
+
+    void put(uint32_t bits, int n) {  // n <= 24
+        acc = (acc << n) | (bits & ((1u << n) - 1));
+        count += n;
+        while (count >= 8) {
+            count -= 8;
+            *ptr++ = (uint8_t) (acc >> count);
+        }
+    }
+
+    void align() { if (count > 0) put(0, 8 - count); }
+};
+
+
+// residual of sample i of s for order, where s[-1] and s[-2] are the
+// history (s points past 2 samples of history):
+static inline int32_t blob_residual(const int32_t *s, int i, int order)
+{
+    if (order == 0) return s[i];
+    if (order == 1) return s[i] - s[i - 1];
+    return s[i] - 2 * s[i - 1] + s[i - 2];
+}
+
+
+int blob_encode(const int16_t *src, int frames, int chans, uint8_t *dst)
+{
+    int nseg = frames * chans / BL;
+    Vec<int32_t> history(2 * chans, true);
+    Blob_bits bits = {dst, 0, 0};
+    int32_t s[BL + 2];
+    uint32_t u[BL];
+    for (int seg = 0; seg < nseg; seg++) {
+        int32_t *hist = &history[2 * (seg % chans)];
+        const int16_t *x = src + seg * BL;
+        s[0] = hist[0];
+        s[1] = hist[1];
+        for (int i = 0; i < BL; i++) {
+            s[i + 2] = x[i];
+        }
+        hist[0] = s[BL];
+        hist[1] = s[BL + 1];
+        // choose the predictor with the least total |residual|:
+        int order = 0;
+        uint32_t best = UINT32_MAX;
+        for (int o = 0; o < 3; o++) {
+            uint32_t total = 0;
+            for (int i = 2; i < BL + 2; i++) {
+                total += (uint32_t) abs(blob_residual(s, i, o));
+            }
+            if (total < best) {
+                best = total;
+                order = o;
+            }
+        }
+        uint32_t sum = 0;
+        for (int i = 0; i < BL; i++) {
+            int32_t e = blob_residual(s, i + 2, order);
+            u[i] = e >= 0 ? (uint32_t) e << 1 : ((uint32_t) -e << 1) - 1;
+            sum += u[i];
+        }
+        // k such that the mean of u is about 2^k:
+        int k = 0;
+        while (k < 30 && ((uint32_t) BL << k) < sum) k++;
+        int size = BL * (k + 1);
+        for (int i = 0; i < BL; i++) {
+            size += u[i] >> k;
+        }
+        if (size >= BL * 16) {  // store the samples
+            bits.put((order << 5) | 31, 8);
+            for (int i = 0; i < BL; i++) {
+                bits.put((uint16_t) x[i], 16);
+            }
+            continue;
+        }
+        bits.put((order << 5) | k, 8);
+        for (int i = 0; i < BL; i++) {
+            uint32_t q = u[i] >> k;
+            while (q >= 24) {
+                bits.put(0, 24);
+                q -= 24;
+            }
+            bits.put(1, q + 1);
+            if (k > 16) {
+                bits.put(u[i] >> 16, k - 16);
+                bits.put(u[i], 16);
+            } else if (k > 0) {
+                bits.put(u[i], k);
+            }
+        }
+        bits.align();
+    }
+    return (int) (bits.ptr - dst);
+}
+
+
+bool blob_decode(const uint8_t *src, int len, int frames, int chans,
+                 int16_t *dst)
+{
+    int nseg = frames * chans / BL;
+    Vec<int32_t> history(2 * chans, true);
+    const uint8_t *end = src + len;
+    for (int seg = 0; seg < nseg; seg++) {
+        int32_t *hist = &history[2 * (seg % chans)];
+        int16_t *x = dst + seg * BL;
+        if (src >= end) return false;
+        int order = *src >> 5;
+        int k = *src++ & 31;
+        if (order > 2) return false;
+        if (k == 31) {
+            if (end - src < BL * 2) return false;
+            for (int i = 0; i < BL; i++) {
+                x[i] = (int16_t) ((src[0] << 8) | src[1]);
+                src += 2;
+            }
+        } else {
+            uint32_t acc = 0;  // bits not yet used, left-aligned
+            int count = 0;
+            int32_t s1 = hist[1], s2 = hist[0];
+            for (int i = 0; i < BL; i++) {
+                uint32_t q = 0;
+                while (true) {  // unary quotient
+                    if (count == 0) {
+                        if (src >= end || q > BL * 16) return false;
+                        acc = (uint32_t) *src++ << 24;
+                        count = 8;
+                    }
+                    if (acc & 0x80000000u) break;
+                    acc <<= 1;
+                    count--;
+                    q++;
+                }
+                acc <<= 1;  // consume the 1 bit
+                count--;
+                uint32_t r = 0;
+                for (int n = k; n > 0; ) {  // remainder
+                    if (count == 0) {
+                        if (src >= end) return false;
+                        acc = (uint32_t) *src++ << 24;
+                        count = 8;
+                    }
+                    int m = MIN(n, count);
+                    r = (r << m) | (acc >> (32 - m));
+                    acc <<= m;
+                    count -= m;
+                    n -= m;
+                }
+                uint32_t u = (q << k) | r;
+                int32_t e = (u & 1) ? -(int32_t) (u >> 1) - 1
+                                    : (int32_t) (u >> 1);
+                int32_t p = order == 0 ? 0 :
+                            (order == 1 ? s1 : 2 * s1 - s2);
+                int32_t v = p + e;
+                if (v < -32768 || v > 32767) return false;
+                x[i] = (int16_t) v;
+                s2 = s1;
+                s1 = v;
+            }
+        }
+        hist[0] = x[BL - 2];
+        hist[1] = x[BL - 1];
+    }
+    return true;
 }
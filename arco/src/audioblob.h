@@ -4,26 +4,97 @@
  * Aug, 2024
  */
 
+// convert between network and host byte order (no-op on big-endian hosts)
 void blob_byteswap(char *data, int frames, int chans, bool floattype);
 
+// reverse the byte order of every sample
+void blob_swap(char *data, int frames, int chans, bool floattype);
+
+/* sampletype is 0 for int16, 1 for float or SAMPLETYPE_CODED. Raw
+ * samples are big-endian unless SAMPLETYPE_LITTLE is added, which
+ * lets peers with the same byte order as the host skip swapping.
+ */
+#define SAMPLETYPE_LITTLE 4
+
+/* Coded blobs (sampletype 2) carry int16 samples compressed by a
+ * lossless predictive coder, similar to Shorten, with no delay beyond
+ * the message itself. The samples are coded in blob order as
+ * frames * chans / BL segments of BL samples, where segment j belongs
+ * to channel j % chans. Each channel has its own predictor history,
+ * which starts at zero in every message so that messages can be
+ * dropped. Each segment is byte-aligned and starts with a header
+ * byte: (order << 5) | k. order (0 to 2) selects a fixed polynomial
+ * predictor: 0, s[n-1] or 2 s[n-1] - s[n-2]. Each residual e is mapped
+ * to u = 2e (e >= 0) or -2e - 1 (e < 0) and Rice coded with
+ * parameter k (0 to 30): u >> k as that many 0 bits and a 1 bit,
+ * then the low k bits of u, most significant bit first. If k is 31,
+ * the segment is BL big-endian int16 samples instead. Typical music
+ * takes 8 to 12 bits per sample, and silence takes 1.25.
+ */
+#define SAMPLETYPE_CODED 2
+#define BLOB_CODED_MAX(frames, chans) \
+        ((frames) * (chans) / BL * (1 + BL * 2))
+
+// code frames * chans samples from src into dst, which must have room
+// for BLOB_CODED_MAX(frames, chans) bytes. Returns the coded length.
+int blob_encode(const int16_t *src, int frames, int chans, uint8_t *dst);
+
+// decode len bytes of src into frames * chans samples at dst (host
+// byte order). Returns false if src is not a valid coded blob.
+bool blob_decode(const uint8_t *src, int len, int frames, int chans,
+                 int16_t *dst);
+
+/* An Audioblob accumulates blocks of samples for a message. Samples
+ * are converted to int16 (if not floattype) and each block of frames
+ * is stored as chans consecutive blocks of BL samples.
+ *
+ * By default, samples go to blob in host byte order. After
+ * use_messages(), samples are instead written directly into a
+ * complete O2 message, "ithb" id when framecount samples, converted to
+ * the requested byte order as they are written, so nothing is copied
+ * or swapped when the message is sent: finish_message() fills in when
+ * and framecount and returns the message for o2sm_message_send().
+ * Message memory comes from a Bufferpool (see bufferpool.h), so the
+ * audio thread normally does not call the allocator either.
+ */
+
+#define AUDIOBLOB_RESERVE 4  // pooled messages to keep available
+
 class Audioblob {
   public:
     bool floattype;  // false for int16, true for float
+    bool swap;       // reverse byte order of samples as they are added
     int chans;       // how many channels
     int frames;      // how many frames - multiple of BL
     int next;        // count of how many frames written so far
-    O2blob_ptr blob;  // allocated with o2_blob_new()
+    int chan;        // channel of the next block to add
+    O2blob_ptr blob;  // allocated with o2_blob_new(), NULL for messages
+    char *data;      // where samples are written, or NULL
+
+    // message mode:
+    char *header;    // message up to the samples, with id and blob size
+    int header_len;
+    int msg_len;
+    O2message_ptr msg;  // message being filled
+    Bufferpool *pool;
 
     Audioblob(bool floattype_, int chans_, int frames_) {
         assert((frames_ / BL) * BL == frames_);  // multiple of BL
         floattype = floattype_;
+        swap = false;
         chans = chans_;
         frames = frames_;
         next = 0;
+        chan = 0;
+        header = NULL;
+        msg = NULL;
+        pool = NULL;
         if (chans > 0) {
             blob = o2_blob_new(frames * chans * 2 * (floattype + 1));
+            data = blob->data;
         } else {
             blob = NULL;
+            data = NULL;
         }
     }
 
@@ -31,30 +102,62 @@ class Audioblob {
         if (blob) {
             O2_FREE(blob);
         }
+        if (header) {
+            O2_FREE(header);
+        }
+        if (msg) {
+            O2_FREE(msg);
+        }
+        if (pool) {
+            pool->reserve(-AUDIOBLOB_RESERVE);
+        }
     }
 
+    void use_messages(const char *address, int32_t id, bool little);
+
     bool is_full() { return next == frames; }
 
     void add_samples(Sample_ptr src) {
     // add one block of samples to content of blob, converting to 16-bit
-    // if not floattype:
+    // if not floattype. Call once per channel:
+        if (!data) {
+            start_message();
+        }
+        int offset = next * chans + chan * BL;
         if (floattype) {
-            float *outptr = ((float *) blob->data) + next * chans;
-            block_copy(outptr, src);
+            float *outptr = ((float *) data) + offset;
+            if (swap) {
+                int32_t *dst = (int32_t *) outptr;
+                const int32_t *s = (const int32_t *) src;
+                for (int i = 0; i < BL; i++) {
+                    dst[i] = swap32(s[i]);
+                }
+            } else {
+                block_copy(outptr, src);
+            }
         } else {  // 16-bit
-            int16_t *outptr = ((int16_t *) blob->data) + next * chans;
-            for (int i = 0; i < BL; i++) {
-                 *outptr++ = FLOAT_TO_INT16(FLOAT_CLIP(*src++));
+            int16_t *outptr = ((int16_t *) data) + offset;
+            if (swap) {
+                for (int i = 0; i < BL; i++) {
+                    int16_t x = FLOAT_TO_INT16(FLOAT_CLIP(src[i]));
+                    outptr[i] = swap16(x);
+                }
+            } else {
+                for (int i = 0; i < BL; i++) {
+                    outptr[i] = FLOAT_TO_INT16(FLOAT_CLIP(src[i]));
+                }
             }
         }
-        next += BL;
+        if (++chan == chans) {
+            chan = 0;
+            next += BL;
+        }
         assert(next <= frames);
     }
 
-    void add_blob() {
-        // add blob using o2sm_add_blob after byte-swapping to network order
-        blob_byteswap(blob->data, frames, chans, floattype);
-        o2sm_add_blob(blob);
-        next = 0;  // start refilling message after sending
-    }
+    void start_message();
+
+    O2message_ptr finish_message(double when, int64_t framecount);
+
+    void clear() { next = 0; chan = 0; }
 };
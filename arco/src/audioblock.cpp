@@ -8,10 +8,10 @@
 #include <o2.h>
 #include "audioblock.h"
 
-Audioblock *audioblock_alloc(int chans)
+Audioblock *audioblock_alloc(int chans, int frames)
 {
     long bytes = sizeof(Audioblock) + 
-                 sizeof(int16_t) * chans * AUDIOBLOCK_FRAMES;
+                 sizeof(int16_t) * chans * frames;
     Audioblock *ab = (Audioblock *) O2_MALLOC(bytes);
     // ahprintf("audioblock_alloc: %d frames, %ld bytes, %ld%% internal frag\n",
     //          AUDIOBLOCK_FRAMES, bytes, (long)
@@ -13,7 +13,9 @@ typedef struct  {
 } Audioblock;
 
 
-Audioblock *audioblock_alloc(int chans);
+// allocate an Audioblock with room for frames (default AUDIOBLOCK_FRAMES)
+// frames of chans channels:
+Audioblock *audioblock_alloc(int chans, int frames = AUDIOBLOCK_FRAMES);
 
 
 #endif // AUDIOBLOCK_H
@@ -318,6 +318,8 @@ See doc/design.md
 #include "sum.h"
 #include "thru.h"
 #include "fileio.h"  // for fileio_finished declaration
+#include "bufferpool.h"
+#include "offload.h"
 
 // audio debug output is enabled or disabled here:
 #define AUDIO_DEBUG 1
@@ -978,6 +980,7 @@ static int callback_entry(float *input, float *output,
     */
 
     o2sm_poll();  // called here to get block-accurate timing
+    offload_finish();  // publish results of work done by main thread
     aud_frames_done += BL;
     // If main program is shutting down due to an error, it could free the
     // audio thread's memory. That shouldn't happen, but did once, so this
@@ -1434,12 +1437,17 @@ void arco_gain(O2SM_HANDLER_ARGS)
 
 
 // called to keep this zone running when there are no audio callbacks
-// this can be called directly from the main O2 thread.
+// this can be called directly from the main O2 thread. It is also
+// where the main thread refills Bufferpools (see bufferpool.h) and
+// runs offloaded jobs (see offload.h).
 void arco_thread_poll()
 {
     if (aud_state == FINISHED) {
         return;
     }
+    // allocate buffers and do offloaded work for the audio thread:
+    bufferpool_refill();
+    offload_run();
     if (aud_state == STARTED) {
         aud_state = FIRST;
         AD("aud_state = FIRST;\n");
@@ -1475,6 +1483,7 @@ void arco_thread_poll()
     void *save_ctx = o2_set_context(aud_o2_ctx);
     assert(aud_state != FINISHED);
     o2sm_poll();
+    offload_finish();
     // restore thread local context
     o2_set_context(save_ctx);
 }
@@ -111,7 +111,7 @@ class Blockqueue : public Vec<char> {
     void dequeue(char *s_ptr) {
     // dequeue n samples and copy them to s_ptr
         assert(get_fifo_len() > 0);
-        memcpy(s_ptr, &((*this)[head]), blocksize);
+        memcpy(s_ptr, &((*this)[head * blocksize]), blocksize);
         INCR_WRAPPED(head);
     }
 
@@ -128,6 +128,16 @@ class Blockqueue : public Vec<char> {
     }
 
 
+    char *peek(int n) {
+    // return the address of the nth block from the head (n = 0 for the
+    // block that would be dequeued next) without removing anything
+        assert(n < get_fifo_len());
+        int index = head + n;
+        if (index > size()) index -= size() + 1;
+        return &((*this)[index * blocksize]);
+    }
+
+
     void toss() {
     // remove blocksize bytes from head (data is unused)
         INCR_WRAPPED(head);
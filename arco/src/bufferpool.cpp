@@ -0,0 +1,85 @@
+/* bufferpool.cpp -- preallocated sample buffers for the audio thread
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
+
+static Bufferpool *bufferpools = NULL;  // list of all pools
+
+// buffers of any size to be freed by the main thread:
+static O2queue bufferpool_discards;
+
+// power-of-2 pools from 2^LOG2_POW2_MIN to 2^LOG2_POW2_MAX samples. The
+// smallest are for O2 messages (see Probe and Audioblob); the largest
+// is about 3 minutes at 44100 Hz. Each pool is list-initialized in
+// place ({n}, not n) because Bufferpool, having atomic members, cannot
+// be copied or moved, which copy-initialization requires before C++17:
+#define LOG2_POW2_MIN 7
+#define LOG2_POW2_MAX 23
+static Bufferpool bufferpool_pow2s[LOG2_POW2_MAX - LOG2_POW2_MIN + 1] = {
+    {1 << 7}, {1 << 8}, {1 << 9}, {1 << 10}, {1 << 11}, {1 << 12},
+    {1 << 13}, {1 << 14}, {1 << 15}, {1 << 16}, {1 << 17}, {1 << 18},
+    {1 << 19}, {1 << 20}, {1 << 21}, {1 << 22}, {1 << 23} };
+
+
+Bufferpool::Bufferpool(int samples_) : available(0), target(0), misses(0)
+{
+    samples = samples_;
+    // called only during static initialization, so no locking is needed:
+    next = bufferpools;
+    bufferpools = this;
+}
+
+
+void Bufferpool::refill()
+{
+    int want = target;
+    while (available < want) {
+        put(O2_MALLOCNT(samples, Sample));
+    }
+    while (available > 2 * want) {
+        Sample_ptr buffer = (Sample_ptr) buffers.pop();
+        if (!buffer) {
+            break;
+        }
+        available--;
+        O2_FREE(buffer);
+    }
+}
+
+
+Bufferpool *bufferpool_pow2(int samples)
+{
+    for (int i = LOG2_POW2_MIN; i <= LOG2_POW2_MAX; i++) {
+        if (samples <= (1 << i)) {
+            return &bufferpool_pow2s[i - LOG2_POW2_MIN];
+        }
+    }
+    return NULL;
+}
+
+
+void bufferpool_discard(void *buffer)
+{
+    if (buffer) {
+        bufferpool_discards.push((O2list_elem *) buffer);
+    }
+}
+
+
+void bufferpool_refill()
+{
+    O2list_elem *buffer = bufferpool_discards.grab();
+    while (buffer) {
+        O2list_elem *next = buffer->next;
+        O2_FREE(buffer);
+        buffer = next;
+    }
+    for (Bufferpool *pool = bufferpools; pool; pool = pool->next) {
+        pool->refill();
+    }
+}
@@ -0,0 +1,87 @@
+/* bufferpool.h -- preallocated sample buffers for the audio thread
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Unit generators that grow their storage while running, e.g. Recplay
+ * while recording and Granstream when its duration increases, should
+ * not call the memory allocator from the audio thread, where a large
+ * allocation can take long enough to cause an audio dropout.
+ *
+ * A Bufferpool is a lock-free stack of buffers, all with the same
+ * number of samples. The audio thread takes buffers with get() and
+ * returns them with put(). bufferpool_refill(), called by the main
+ * thread from arco_thread_poll(), allocates buffers so that at least
+ * `reserve` buffers are available, and frees buffers beyond twice
+ * that number. Ugens adjust the reserve with reserve(n) according to
+ * how many buffers they might need before the next refill.
+ *
+ * If a pool is empty, get() returns NULL and counts a miss. The caller
+ * can fall back to allocating (Recplay does) or wait for a later block
+ * (Granstream does).
+ *
+ * Buffers of other sizes can be handed to bufferpool_discard() to be
+ * freed by the main thread.
+ *
+ * Buffers are allocated with O2_MALLOC, so a buffer can also hold an
+ * O2 message that is sent with o2sm_message_send() and freed by O2
+ * (see Probe and Audioblob).
+ *
+ * Pools are static objects, so they exist before any Ugen is created
+ * and refilling them never races with their construction.
+ */
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+
+#include <atomic>
+
+class Bufferpool {
+  public:
+    int samples;  // how many samples in each buffer
+    O2queue buffers;  // available buffers, linked through their first word
+    std::atomic<int> available;  // how many in buffers
+    std::atomic<int> target;     // how many we want available
+    std::atomic<int> misses;     // how many times get() found no buffer
+    Bufferpool *next;  // all pools are on a list for bufferpool_refill()
+
+    Bufferpool(int samples_);
+
+    // get a buffer or NULL if none is available (audio thread)
+    Sample_ptr get() {
+        Sample_ptr buffer = (Sample_ptr) buffers.pop();
+        if (buffer) {
+            available--;
+        } else {
+            misses++;
+        }
+        return buffer;
+    }
+
+    // return a buffer of samples samples (audio thread)
+    void put(Sample_ptr buffer) {
+        buffers.push((O2list_elem *) buffer);
+        available++;
+    }
+
+    // change how many buffers to keep available by n (which may be
+    // negative). Call with n > 0 before you need the buffers and with
+    // -n when you no longer need them.
+    void reserve(int n) { target += n; }
+
+    void refill();  // main thread only
+};
+
+
+// get the pool of power-of-2 sized buffers with at least samples
+// samples, or NULL if samples is larger than the largest pool.
+Bufferpool *bufferpool_pow2(int samples);
+
+// free buffer (of any size) from the main thread (audio thread)
+void bufferpool_discard(void *buffer);
+
+// allocate and free buffers as needed (main thread)
+void bufferpool_refill();
+
+#endif
@@ -21,8 +21,16 @@ void Chorddetect::real_run()
     if (chromagram.isReady()) { // only runs if we have enough samples
         
         float* chroma = chromagram.getChromagram();
-        ChordDetector chord_detector;
         chord_detector.detectChord(chroma);
+        bool found = (chord_detector.confidence >= threshold);
+        features[0] = (found ? chord_detector.rootNote : -1);
+        features[1] = (found ? chord_detector.quality : -1);
+        features[2] = (found ? chord_detector.intervals : 0);
+        features[3] = chord_detector.confidence;
+        feature_frames++;
+        if (!cd_reply_addr[0]) {
+            return;
+        }
         // send message with chord information
         o2sm_send_start();
         if (chord_detector.confidence >= threshold) {
@@ -83,6 +91,25 @@ static void arco_chorddetect_start(O2SM_HANDLER_ARGS)
 }
 
 
+void Chorddetect::set_hop(int hop) {
+    // at least one block, since the chromagram is computed per block
+    chromagram.setChromaCalculationInterval(MAX(hop, BL));
+}
+
+/* O2SM INTERFACE: /arco/chorddetect/hop int32 id, int32 hop;
+ */
+static void arco_chorddetect_hop(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t hop = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Chorddetect, chorddetect, id, "arco_chorddetect_hop");
+    chorddetect->set_hop(hop);
+}
+
+
 /* O2SM INTERFACE: /arco/chorddetect/repl_input int32 id, int32 input_id;
  */
 static void arco_chorddetect_repl_input(O2SM_HANDLER_ARGS)
@@ -120,6 +147,8 @@ static void chorddetect_init()
     // O2SM INTERFACE INITIALIZATION: (machine generated)
     o2sm_method_new("/arco/chorddetect/start", "is", arco_chorddetect_start,
                     NULL, true, true);
+    o2sm_method_new("/arco/chorddetect/hop", "ii", arco_chorddetect_hop,
+                    NULL, true, true);
     o2sm_method_new("/arco/chorddetect/repl_input", "ii",
                     arco_chorddetect_repl_input, NULL, true, true);
     o2sm_method_new("/arco/chorddetect/new", "iis", arco_chorddetect_new,
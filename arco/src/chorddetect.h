@@ -15,6 +15,9 @@ extern const char *Chorddetect_name;
 class Chorddetect : public Ugen {
 public:
     char *cd_reply_addr; // Reply address for O2
+    // latest root, quality, intervals and confidence (see get_features())
+    Sample features[4];
+    int feature_frames;
     
     Chromagram chromagram;
     ChordDetector chord_detector;
@@ -28,6 +31,8 @@ public:
                 double display_threshold = 0.0005) :
             Ugen(id, 0, 0), chromagram(BL, AR) {
         cd_reply_addr = NULL;
+        memset(features, 0, sizeof(features));
+        feature_frames = 0;
         init_input(input);
         threshold = display_threshold;
         start(reply_addr);
@@ -88,6 +93,16 @@ public:
 
     void start(const char *reply_addr);
 
+    void set_hop(int hop);
+
+    // root and quality are -1 and intervals is 0 when confidence is
+    // below threshold (where messages have "None")
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = features;
+        *frame_count = feature_frames;
+        return 4;
+    }
+
     void real_run();
 };
 
@@ -154,6 +154,20 @@ public:
     void init_dur(Ugen_ptr ugen) { init_param(ugen, dur, &dur_stride); }
     void init_fb(Ugen_ptr ugen) { init_param(ugen, fb, &fb_stride); }
         
+    // Fast path for block-rate dur: if the delay is at least one block,
+    // no sample is read after it is written within the block, so we
+    // can read the whole block of output with read_nth(), compute
+    // input + feedback in a vectorizable loop, and then filter and write
+    // the result as a block.
+    void enqueue_filtered(Delay_state *state, Sample *x) {
+        Dcblock &dcblock = state->dcblock;
+        for (int i = 0; i < BL; i++) {
+            x[i] = dcblock.filter(x[i]);
+        }
+        state->samps.toss(BL);  // make space
+        state->samps.enqueue_block(x);
+    }
+
     void chan_aaa_a(Delay_state *state) {
         Sample_ptr input = input_samps;
         Sample_ptr dur = dur_samps;
@@ -209,6 +223,17 @@ public:
         if (len > delay.size()) {
             set_state_max(state, len);
         }
+        if (len >= BL) {
+            Sample out[BL];
+            delay.read_nth(out, len);
+            for (int i = 0; i < BL; i++) {
+                out_samps[i] = out[i];
+                out[i] = input[i] + out[i] * fb[i];
+            }
+            enqueue_filtered(state, out);
+            out_samps += BL;
+            return;
+        }
 
         for (int i = 0; i < BL; i++) {
             // get from delay line
@@ -232,6 +257,17 @@ public:
             set_state_max(state, len);
         }
         state->fb_prev = fb;
+        if (len >= BL) {
+            Sample out[BL];
+            delay.read_nth(out, len);
+            for (int i = 0; i < BL; i++) {
+                out_samps[i] = out[i];
+                out[i] = input[i] + out[i] * (fb_prev + fb_incr * (i + 1));
+            }
+            enqueue_filtered(state, out);
+            out_samps += BL;
+            return;
+        }
 
         for (int i = 0; i < BL; i++) {
             fb_prev += fb_incr;
@@ -0,0 +1,129 @@
+/* featurevec.cpp -- collect analysis results into one vector per frame
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "featurevec.h"
+
+const char *Featurevec_name = "Featurevec";
+
+
+void Featurevec::real_run()
+{
+    bool new_frame = false;
+    int chan = 0;  // first output channel of this source
+    for (int i = 0; i < sources.size(); i++) {
+        Ugen_ptr source = sources[i];
+        source->run(current_block);
+        Sample_ptr values;
+        int frame_count;
+        int n = source->get_features(&values, &frame_count);
+        if (frame_count != source_frames[i]) {
+            source_frames[i] = frame_count;
+            new_frame = true;
+            if (chan < chans) {
+                memcpy(out_samps + chan, values,
+                       MIN(n, chans - chan) * sizeof(Sample));
+            }
+        }
+        chan += n;
+    }
+
+    if (new_frame && reply_addr[0]) {
+        o2sm_send_start();
+        o2sm_add_int32(id);
+        o2sm_add_double(current_block / BR);
+        for (int i = 0; i < chans; i++) {
+            o2sm_add_float(out_samps[i]);
+        }
+        o2sm_send_finish(0, reply_addr, false);
+    }
+}
+
+
+void Featurevec::start(const char *reply_addr_)
+{
+    if (reply_addr) {
+        O2_FREE(reply_addr);
+    }
+    reply_addr = O2_MALLOCNT(strlen(reply_addr_) + 1, char);
+    strcpy(reply_addr, reply_addr_);
+}
+
+
+/* O2SM INTERFACE: /arco/featurevec/new int32 id, int32 chans,
+       string reply_addr;
+ */
+static void arco_featurevec_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chans = argv[1]->i;
+    char *reply_addr = argv[2]->s;
+    // end unpack message
+
+    new Featurevec(id, chans, reply_addr);
+}
+
+
+/* O2SM INTERFACE: /arco/featurevec/ins int32 id, int32 source_id;
+ */
+static void arco_featurevec_ins(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t source_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Featurevec, featurevec, id, "arco_featurevec_ins");
+    ANY_UGEN_FROM_ID(source, source_id, "arco_featurevec_ins");
+    featurevec->ins(source);
+}
+
+
+/* O2SM INTERFACE: /arco/featurevec/rem int32 id, int32 source_id;
+ */
+static void arco_featurevec_rem(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t source_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Featurevec, featurevec, id, "arco_featurevec_rem");
+    ANY_UGEN_FROM_ID(source, source_id, "arco_featurevec_rem");
+    featurevec->rem(source);
+}
+
+
+/* O2SM INTERFACE: /arco/featurevec/start int32 id, string reply_addr;
+ */
+static void arco_featurevec_start(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    char *reply_addr = argv[1]->s;
+    // end unpack message
+
+    UGEN_FROM_ID(Featurevec, featurevec, id, "arco_featurevec_start");
+    featurevec->start(reply_addr);
+}
+
+
+static void featurevec_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/featurevec/new", "iis", arco_featurevec_new, NULL,
+                    true, true);
+    o2sm_method_new("/arco/featurevec/ins", "ii", arco_featurevec_ins, NULL,
+                    true, true);
+    o2sm_method_new("/arco/featurevec/rem", "ii", arco_featurevec_rem, NULL,
+                    true, true);
+    o2sm_method_new("/arco/featurevec/start", "is", arco_featurevec_start,
+                    NULL, true, true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer featurevec_init_obj(featurevec_init);
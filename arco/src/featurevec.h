@@ -0,0 +1,126 @@
+/* featurevec.h -- collect analysis results into one vector per frame
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Featurevec runs a list of analysis ugens (Yin, Onset, SpectralCentroid,
+ * SpectralRolloff, Chorddetect) and gathers their latest results (see
+ * Ugen::get_features()) into a block-rate output with one channel per
+ * value, in the order the sources were inserted:
+ *     Yin: pitch, harmonicity, rms for each channel
+ *     Onset: 1 (onset) or 0 for each channel
+ *     SpectralCentroid, SpectralRolloff: 1 value
+ *     Chorddetect: root, quality, intervals, confidence
+ * Values hold until their source computes a new frame, so the output
+ * can drive DSP directly. Sources with more values than remaining
+ * output channels are truncated.
+ *
+ * In any block where at least one source has a new frame, and
+ * reply_addr is not empty, Featurevec sends one message:
+ *     reply_addr "id" + "f" * chans: id, time, then all values
+ * where time is audio time in seconds at the end of the block. Give
+ * the sources an empty reply address to stop their own messages.
+ */
+
+#ifndef __Featurevec_H__
+#define __Featurevec_H__
+
+extern const char *Featurevec_name;
+
+class Featurevec : public Ugen {
+public:
+    char *reply_addr;
+    Vec<Ugen_ptr> sources;
+    Vec<int> source_frames;  // frame count of each source's last values
+
+    Featurevec(int id, int nchans, const char *reply_addr_) :
+            Ugen(id, 'b', nchans) {
+        reply_addr = NULL;
+        memset(out_samps, 0, chans * sizeof(Sample));
+        start(reply_addr_);
+    }
+
+    ~Featurevec() {
+        for (int i = 0; i < sources.size(); i++) {
+            sources[i]->unref(&(sources[i]));
+        }
+        if (reply_addr) {
+            O2_FREE(reply_addr);
+        }
+    }
+
+    const char *classname() { return Featurevec_name; }
+
+#if ARCO_REF_DEBUG
+    // for tracing tree of Ugens. Returns true with the ith child in *child
+    // or false if i is too high.
+    bool get_ref(int i, Ugen **child) {
+        if (i < 0 || i >= sources.size()) {
+            return false;
+        }
+        *child = sources[i];
+        return true;
+    }
+#endif
+
+    void print_details(int indent) {
+        arco_print("reply_addr %s sources %d", reply_addr, sources.size());
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        for (int i = 0; i < sources.size(); i++) {
+            char name[8];
+            snprintf(name, 8, "%d", i);
+            sources[i]->print_tree(indent, print_flag, name);
+        }
+    }
+
+    int find(Ugen_ptr source) {
+        for (int i = 0; i < sources.size(); i++) {
+            if (sources[i] == source) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // append source to the list
+    void ins(Ugen_ptr source) {
+        if (find(source) >= 0) {
+            return;
+        }
+        Sample_ptr values;
+        int frame_count;
+        if (source->get_features(&values, &frame_count) == 0) {
+            arco_warn("Featurevec: %s has no features, ignored",
+                      source->classname());
+            return;
+        }
+        sources.push_back(source);
+        source_frames.push_back(-1);  // output values at the next block
+        source->ref();
+    }
+
+    // remove source; later sources move to lower channels
+    void rem(Ugen_ptr source) {
+        int i = find(source);
+        if (i < 0) {
+            arco_warn("Featurevec::rem: %d not found, nothing was changed",
+                      source->id);
+            return;
+        }
+        source->unref(&(sources[i]));
+        sources.erase(i, 1);
+        source_frames.erase(i, 1);
+        for (int j = i; j < source_frames.size(); j++) {
+            source_frames[j] = -1;  // recopy moved values
+        }
+    }
+
+    void start(const char *reply_addr_);
+
+    void real_run();
+};
+
+#endif
@@ -46,6 +46,10 @@ public:
     // poll() will be called every period ms:
     void poll() {
         o2sm_poll();
+        // let readers decode ahead:
+        for (int i = 0; i < fileio_objs.size(); i++) {
+            fileio_objs[i]->poll();
+        }
     }
 
 
@@ -65,6 +69,19 @@ public:
 static Fileio_actual fileio_actual;
 
 
+// Decode-ahead: PCM files are cheap to read, so Fileio_reader reads
+// each Audioblock when Fileplay requests it, and Fileplay's double
+// buffering hides the latency. Compressed files (FLAC, Ogg, MP3) cost
+// much more to decode, and since one fileio thread serves every stream,
+// a slow decode delays all the other streams too. Therefore, readers of
+// compressed files decode additional blocks in advance whenever the
+// fileio thread polls, and requests are then answered immediately from
+// this backlog. The backlog size starts with a guess based on the codec
+// and grows with the measured decode time: one block for each
+// DECODE_AHEAD_LOAD fraction of real time spent decoding.
+#define DECODE_AHEAD_MAX 6  // maximum number of blocks decoded in advance
+#define DECODE_AHEAD_LOAD 0.1
+
 class Fileio_reader : public Fileio_obj {
 public:
     float start;
@@ -74,14 +91,24 @@ public:
     
     SNDFILE *snd_in;  // file descriptor
     SF_INFO snd_in_info;  // sfinfo structure (sample rate, format, etc.)
-    Audioblock *blocks[2];  // pointers to buffers
+    Vec<Audioblock *> ready;  // decoded blocks, not yet sent (FIFO)
+    Vec<Audioblock *> sent;  // blocks sent to Fileplay (FIFO, at most 2)
+    Vec<Audioblock *> spare;  // free blocks to decode into
     int64_t all_frames_count;  // how many frames to read from file
     int64_t frames_to_end;  // how many more frames to read until end time
-    int block_on_deck;  // which block do we read and send next?
+    bool decoded_last;  // the last block has been decoded
+    const char *codec;  // short name of the file encoding for stats
+    int ahead;  // how many decoded blocks to keep in ready
+    int codec_ahead;  // initial (minimum) value for ahead
+    int blocks_decoded;  // decode statistics:
+    double decode_time;  // total time spent decoding
+    double decode_max;  // longest time to decode one block
     
 
-    Fileio_reader(int64_t addr, char *fn, float st, float en, bool cy) :
-            Fileio_obj(addr) {
+    // skip is the number of frames after start that are already
+    // available to Fileplay from a primed head (see fileplay.h)
+    Fileio_reader(int64_t addr, char *fn, float st, float en, bool cy,
+                  int skip) : Fileio_obj(addr) {
         int rslt = -1;  // failure until we open file and seek
         start = st;
         end = en;
@@ -89,7 +116,10 @@ public:
         all_frames_count = 2000000000000;  // we'll stop at eof
         
         file_is_open = false;
-        block_on_deck = 0;
+        decoded_last = false;
+        blocks_decoded = 0;
+        decode_time = 0;
+        decode_max = 0;
         snd_in_info.format = 0;
         snd_in = sf_open(fn, SFM_READ, &snd_in_info);
         if (snd_in) {
@@ -104,50 +134,151 @@ public:
         } else if (end > 0) {
             all_frames_count = (end - start) * snd_in_info.samplerate;
         }
+        set_codec();
 
         int chans  = snd_in_info.channels;
-        blocks[0] = audioblock_alloc(chans);
-        blocks[1] = audioblock_alloc(chans);
-
-        if (start > 0.0 && file_is_open) {
-            rslt = (int) sf_seek(snd_in, (sf_count_t)
-                                 (start * snd_in_info.samplerate), SEEK_SET);
+        if (skip >= all_frames_count) {  // head covers start to end
+            skip = 0;
+            if (!cycle) {  // nothing more to read
+                all_frames_count = 0;
+            }
+        }
+        sf_count_t first_frame = (sf_count_t)
+                                 (start * snd_in_info.samplerate) + skip;
+        if (first_frame > 0 && file_is_open) {
+            rslt = (int) sf_seek(snd_in, first_frame, SEEK_SET);
             if (rslt < 0) {  // error in seek -- give up and close the file
                 cycle = false;  // pretend we're at the end of file and no cycles
                 all_frames_count = 0;
+                skip = 0;
             }
         }
-        frames_to_end = all_frames_count;
+        frames_to_end = all_frames_count - skip;
         
-        // o2sm_send_cmd("/arco/fileplay/ready", 0, "hiB", addr,
-        //               (file_is_open ? chans : 0), rslt < 0);
+        // o2sm_send_cmd("/arco/fileplay/ready", 0, "hiBi", addr,
+        //               (file_is_open ? chans : 0), rslt < 0, samplerate);
         o2_send_start();
         o2_add_int64(addr);
         o2_add_int32(file_is_open ? chans : 0);
         o2_add_bool(rslt >= 0);
+        o2_add_int32(file_is_open ? snd_in_info.samplerate : 0);
         O2message_ptr msg = o2_message_finish(0.0, "/arco/fileplay/ready",
                                               true);
         o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) msg);
 
         load_block();  // even if error opening or seeking
-        // only prefetch the first block. When fileplay starts, it requests
-        // another block to achieve double-buffering
+        // only send the first block. When fileplay starts, it requests
+        // another block to achieve double-buffering. Compressed files
+        // also decode ahead when the fileio thread polls.
 
-        arco_print("Opened %s, a %d channel audio file.\n", fn, chans);
+        arco_print("Opened %s, a %d channel %s audio file.\n",
+                   fn, chans, codec);
     }
 
 
     ~Fileio_reader() {
-        if (blocks[0]) {
-            O2_FREE(blocks[0]);
-            O2_FREE(blocks[1]);
-        }
+        free_blocks(ready);
+        free_blocks(sent);
+        free_blocks(spare);
         makeclosed();
     }
 
 
+    void free_blocks(Vec<Audioblock *> &blocks) {
+        for (int i = 0; i < blocks.size(); i++) {
+            O2_FREE(blocks[i]);
+        }
+        blocks.finish();
+    }
+
+
+    // set codec and the initial decode-ahead from the file format
+    void set_codec() {
+        int major = snd_in_info.format & SF_FORMAT_TYPEMASK;
+        int minor = snd_in_info.format & SF_FORMAT_SUBMASK;
+        if (major == SF_FORMAT_FLAC) {
+            codec = "flac";
+            codec_ahead = 1;
+        } else if (major == SF_FORMAT_OGG) {
+            codec = "ogg";
+            codec_ahead = 2;
+        } else if (minor == SF_FORMAT_PCM_S8 || minor == SF_FORMAT_PCM_16 ||
+                   minor == SF_FORMAT_PCM_24 || minor == SF_FORMAT_PCM_32 ||
+                   minor == SF_FORMAT_PCM_U8 || minor == SF_FORMAT_FLOAT ||
+                   minor == SF_FORMAT_DOUBLE || !file_is_open) {
+            codec = "pcm";
+            codec_ahead = 0;
+        } else {  // MP3 and other compressed encodings
+            codec = "compressed";
+            codec_ahead = 2;
+        }
+        ahead = codec_ahead;
+    }
+
+
+    // adjust ahead after a block is decoded in elapsed seconds
+    void update_ahead(double elapsed, int frames) {
+        blocks_decoded++;
+        decode_time += elapsed;
+        if (elapsed > decode_max) {
+            decode_max = elapsed;
+        }
+        if (frames <= 0 || snd_in_info.samplerate <= 0) {
+            return;
+        }
+        // fraction of real time needed to decode this block:
+        double load = elapsed * snd_in_info.samplerate / frames;
+        int needed = codec_ahead + (int) (load / DECODE_AHEAD_LOAD);
+        ahead = MIN(DECODE_AHEAD_MAX, MAX(ahead, needed));
+    }
+
+
+    // called by the fileio thread every polling period
+    void poll() {
+        while (!decoded_last && ready.size() < ahead) {
+            ready.push_back(decode_block());
+        }
+    }
+
+
+    // Fileplay is finished with the oldest block it holds:
+    void release_block() {
+        if (sent.size() > 0) {
+            spare.push_back(sent[0]);
+            sent.drop_front(1);
+        }
+    }
+
+
+    // send the next block to Fileplay, decoding it now if it is not ready
     void load_block() {
-        Audioblock *ablock = blocks[block_on_deck];
+        Audioblock *ablock;
+        if (ready.size() > 0) {
+            ablock = ready[0];
+            ready.drop_front(1);
+        } else {
+            ablock = decode_block();
+        }
+        sent.push_back(ablock);
+
+        // instead of sending through O2, deliver straight to Arco:
+        o2_send_start();
+        o2_add_int64(addr);
+        o2_add_int64((int64_t) ablock);
+        O2message_ptr msg = o2_message_finish(0.0, "/arco/fileplay/samps",
+                                              true);
+        o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) msg);
+    }
+
+
+    Audioblock *decode_block() {
+        Audioblock *ablock;
+        if (spare.size() > 0) {
+            ablock = spare.pop_back();
+        } else {
+            ablock = audioblock_alloc(snd_in_info.channels);
+        }
+        double start_time = o2_native_time();
 
         // read if we need to
         int frames_to_go = AUDIOBLOCK_FRAMES;
@@ -157,8 +288,9 @@ public:
             //     either AUDIOBLOCK_FRAMES or all_frames_count:
             int64_t frames = MIN(frames_to_end, frames_to_go);
             if (frames > 0) {
-                int frames_read = (int) sf_readf_short(snd_in, ablock->dat,
-                                                       frames);
+                int16_t *dst = ablock->dat + (AUDIOBLOCK_FRAMES - frames_to_go) *
+                                             snd_in_info.channels;
+                int frames_read = (int) sf_readf_short(snd_in, dst, frames);
                 if (frames_read < frames) {
                     // we hit end of samples or a read error: act as if EOF
                     all_frames_count = 0;
@@ -170,6 +302,8 @@ public:
                 sf_seek(snd_in, (sf_count_t) (start * snd_in_info.samplerate),
                         SEEK_SET);
                 frames_to_end = all_frames_count;
+            } else if (frames_to_end == 0) {  // reached end time
+                all_frames_count = 0;
             }
         }
         
@@ -177,19 +311,29 @@ public:
         ablock->channels = snd_in_info.channels;
         // if we're out of frames, then tell player we are done:
         ablock->last = frames_to_go > 0;
+        update_ahead(o2_native_time() - start_time, ablock->frames);
 
-        // instead of sending through O2, deliver straight to Arco:
-        o2_send_start();
-        o2_add_int64(addr);
-        o2_add_int64((int64_t) ablock);
-        O2message_ptr msg = o2_message_finish(0.0, "/arco/fileplay/samps",
-                                              true);
-        o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) msg);
-
-        block_on_deck ^= 1;  // swap 0 <-> 1
         if (ablock->last) {
+            decoded_last = true;
             makeclosed();
         }
+        return ablock;
+    }
+
+
+    // send decode statistics to reply_addr. The file may already be
+    // closed after decoding ahead to the end, but statistics remain
+    // valid until the reader is deleted.
+    void stats(const char *reply_addr, int32_t id) {
+        o2sm_send_start();
+        o2sm_add_int32(id);
+        o2sm_add_string(codec);
+        o2sm_add_int32(ahead);
+        o2sm_add_int32(blocks_decoded);
+        o2sm_add_float(blocks_decoded > 0 ?
+                       (float) (decode_time * 1000 / blocks_decoded) : 0.0f);
+        o2sm_add_float((float) (decode_max * 1000));
+        o2sm_send_finish(0.0, reply_addr, true);
     }
     
     
@@ -297,6 +441,113 @@ public:
 };
 
 
+// Fileio_spill holds buffers of samples spilled to disk by a Recplay.
+// Samples are stored in an anonymous temporary file, one region of
+// samples_per_buffer floats for each channel of each buffer.
+//
+class Fileio_spill : public Fileio_obj {
+public:
+    FILE *file;
+    int chans;
+    int samples;  // samples per buffer
+
+    Fileio_spill(int64_t addr, int chans_, int samples_) : Fileio_obj(addr) {
+        chans = chans_;
+        samples = samples_;
+        file = tmpfile();
+        if (!file) {
+            arco_print("Fileio_spill: Failed to create temporary file\n");
+        }
+    }
+
+
+    ~Fileio_spill() {
+        if (file) {
+            fclose(file);
+        }
+    }
+
+
+    bool seek(int chan, int buffer) {
+        int64_t pos = ((int64_t) buffer * chans + chan) * samples *
+                      sizeof(Sample);
+#ifdef WIN32
+        return file && _fseeki64(file, pos, SEEK_SET) == 0;
+#else
+        return file && fseeko(file, (off_t) pos, SEEK_SET) == 0;
+#endif
+    }
+
+
+    void write(int chan, int buffer, Sample_ptr samps) {
+        bool ok = seek(chan, buffer) &&
+                  fwrite(samps, sizeof(Sample), samples, file) == (size_t) samples;
+        // o2sm_send_cmd("/arco/recplay/written", 0, "hiiB", addr, chan,
+        //               buffer, ok);
+        o2_send_start();
+        o2_add_int64(addr);
+        o2_add_int32(chan);
+        o2_add_int32(buffer);
+        o2_add_bool(ok);
+        O2message_ptr msg = o2_message_finish(0.0, "/arco/recplay/written",
+                                              true);
+        o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) msg);
+    }
+
+
+    void read(int chan, int buffer) {
+        Sample_ptr samps = O2_MALLOCNT(samples, Sample);
+        size_t n = 0;
+        if (seek(chan, buffer)) {
+            n = fread(samps, sizeof(Sample), samples, file);
+        }
+        if (n < (size_t) samples) {
+            arco_print("Fileio_spill: short read of buffer %d\n", buffer);
+            memset(samps + n, 0, (samples - n) * sizeof(Sample));
+        }
+        // o2sm_send_cmd("/arco/recplay/paged", 0, "hiih", addr, chan,
+        //               buffer, samps);
+        o2_send_start();
+        o2_add_int64(addr);
+        o2_add_int32(chan);
+        o2_add_int32(buffer);
+        o2_add_int64((int64_t) samps);
+        O2message_ptr msg = o2_message_finish(0.0, "/arco/recplay/paged",
+                                              true);
+        o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) msg);
+    }
+};
+
+
+// read the first dur seconds of a file into a new Audioblock to be
+// kept by Fileplay as a primed head. Returns NULL on failure.
+static Audioblock *fileio_read_head(const char *fn, float dur,
+                                    int *samplerate)
+{
+    SF_INFO info;
+    info.format = 0;
+    SNDFILE *snd = sf_open(fn, SFM_READ, &info);
+    if (!snd) {
+        arco_print("fileio_read_head: Failed to open %s\n", fn);
+        return NULL;
+    }
+    int frames = (int) (dur * info.samplerate);
+    if (frames <= 0) {
+        frames = 1;
+    }
+    Audioblock *head = audioblock_alloc(info.channels, frames);
+    int frames_read = (int) sf_readf_short(snd, head->dat, frames);
+    sf_close(snd);
+    if (frames_read < 0) {
+        frames_read = 0;
+    }
+    head->frames = frames_read;
+    head->last = frames_read < frames;  // head contains the whole file
+    *samplerate = info.samplerate;
+    return head;
+}
+
+
 static int fileio_find(int64_t addr)
 {
     for (int i = 0; i < fileio_objs.size(); i++) {
@@ -313,7 +564,8 @@ static int fileio_find(int64_t addr)
        int64 addr,
        string filename,
        float start, float end,
-       bool cycle;
+       bool cycle,
+       int32 skip;
    Create a new file reader and open the file.
 */
 static void fileio_fileplay_new(O2SM_HANDLER_ARGS)
@@ -324,9 +576,33 @@ static void fileio_fileplay_new(O2SM_HANDLER_ARGS)
     float start = argv[2]->f;
     float end = argv[3]->f;
     bool cycle = argv[4]->B;
+    int32_t skip = argv[5]->i;
+    // end unpack message
+
+    fileio_objs.push_back(new Fileio_reader(addr, filename, start, end, cycle,
+                                            skip));
+}
+
+
+/* O2SM INTERFACE: /fileio/fileplay/prime string filename, float dur;
+   Read the head of a file and send it to /arco/fileplay/primed.
+*/
+static void fileio_fileplay_prime(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    char *filename = argv[0]->s;
+    float dur = argv[1]->f;
     // end unpack message
 
-    fileio_objs.push_back(new Fileio_reader(addr, filename, start, end, cycle));
+    int samplerate = 0;
+    Audioblock *head = fileio_read_head(filename, dur, &samplerate);
+    o2_send_start();
+    o2_add_string(filename);
+    o2_add_int64((int64_t) head);
+    o2_add_int32(samplerate);
+    O2message_ptr armsg = o2_message_finish(0.0, "/arco/fileplay/primed",
+                                            true);
+    o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) armsg);
 }
 
 
@@ -339,11 +615,32 @@ void fileio_fileplay_read(O2SM_HANDLER_ARGS)
 
     int i = fileio_find(addr);
     if (i >= 0) {
-        ((Fileio_reader *) fileio_objs[i])->load_block();
+        Fileio_reader *reader = (Fileio_reader *) fileio_objs[i];
+        reader->release_block();
+        reader->load_block();
     }
 }           
 
 
+/* O2SM INTERFACE: /fileio/fileplay/stats
+       int64 addr, string reply_addr, int32 id;
+   Send decode statistics for the reader to reply_addr.
+*/
+void fileio_fileplay_stats(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    char *reply_addr = argv[1]->s;
+    int32_t id = argv[2]->i;
+    // end unpack message
+
+    int i = fileio_find(addr);
+    if (i >= 0) {
+        ((Fileio_reader *) fileio_objs[i])->stats(reply_addr, id);
+    }
+}
+
+
 /* O2SM INTERFACE: /fileio/fileplay/start int64 addr, bool play_flag; */
 void fileio_fileplay_start(O2SM_HANDLER_ARGS)
 {
@@ -421,6 +718,90 @@ void fileio_filerec_write(O2SM_HANDLER_ARGS)
 }           
 
 
+/* O2SM INTERFACE: /fileio/spill/new
+       int64 addr,
+       int32 chans,
+       int32 samples;
+   Create a temporary file for buffers spilled by a Recplay.
+*/
+static void fileio_spill_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    int32_t chans = argv[1]->i;
+    int32_t samples = argv[2]->i;
+    // end unpack message
+
+    fileio_objs.push_back(new Fileio_spill(addr, chans, samples));
+}
+
+
+/* O2SM INTERFACE: /fileio/spill/write
+       int64 addr,
+       int32 chan,
+       int32 buffer,
+       int64 samps;
+*/
+static void fileio_spill_write(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    int32_t chan = argv[1]->i;
+    int32_t buffer = argv[2]->i;
+    int64_t samps = argv[3]->h;
+    // end unpack message
+
+    int i = fileio_find(addr);
+    if (i >= 0) {
+        Fileio_spill *spill = (Fileio_spill *) fileio_objs[i];
+        spill->write(chan, buffer, (Sample_ptr) samps);
+    }
+}
+
+
+/* O2SM INTERFACE: /fileio/spill/read
+       int64 addr,
+       int32 chan,
+       int32 buffer;
+*/
+static void fileio_spill_read(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    int32_t chan = argv[1]->i;
+    int32_t buffer = argv[2]->i;
+    // end unpack message
+
+    int i = fileio_find(addr);
+    if (i >= 0) {
+        Fileio_spill *spill = (Fileio_spill *) fileio_objs[i];
+        spill->read(chan, buffer);
+    }
+}
+
+
+/* O2SM INTERFACE: /fileio/spill/free int64 addr;
+   Close and delete the spill file. Always replies with
+   /arco/recplay/unspilled so that Recplay can be deleted.
+*/
+static void fileio_spill_free(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    // end unpack message
+
+    int i = fileio_find(addr);
+    if (i >= 0) {
+        delete fileio_objs[i];  // destructor removes it from fileio_objs
+    }
+    o2_send_start();
+    o2_add_int64(addr);
+    O2message_ptr armsg = o2_message_finish(0.0, "/arco/recplay/unspilled",
+                                            true);
+    o2_shmem_inst_outgoing_push(audio_bridge, (O2list_elem *) armsg);
+}
+
+
 // to be called from main thread - creates and starts fileio thread
 // returns non-zero error code if pthread_create fails
 //
@@ -435,17 +816,29 @@ int fileio_initialize()
     o2sm_service_new("fileio", NULL);
 
     // O2SM INTERFACE INITIALIZATION: (machine generated)
-    o2sm_method_new("/fileio/fileplay/new", "hsffB", fileio_fileplay_new,
+    o2sm_method_new("/fileio/fileplay/new", "hsffBi", fileio_fileplay_new,
+                    NULL, true, true);
+    o2sm_method_new("/fileio/fileplay/prime", "sf", fileio_fileplay_prime,
                     NULL, true, true);
     o2sm_method_new("/fileio/fileplay/read", "h", fileio_fileplay_read,
                     NULL, true, true);
     o2sm_method_new("/fileio/fileplay/start", "hB", fileio_fileplay_start,
                     NULL, true, true);
+    o2sm_method_new("/fileio/fileplay/stats", "hsi", fileio_fileplay_stats,
+                    NULL, true, true);
     o2sm_method_new("/fileio/quit", "", fileio_quit, NULL, true, true);
     o2sm_method_new("/fileio/filerec/new", "his", fileio_filerec_new,
                     NULL, true, true);
     o2sm_method_new("/fileio/filerec/write", "hh", fileio_filerec_write,
                     NULL, true, true);
+    o2sm_method_new("/fileio/spill/new", "hii", fileio_spill_new,
+                    NULL, true, true);
+    o2sm_method_new("/fileio/spill/write", "hiih", fileio_spill_write,
+                    NULL, true, true);
+    o2sm_method_new("/fileio/spill/read", "hii", fileio_spill_read,
+                    NULL, true, true);
+    o2sm_method_new("/fileio/spill/free", "h", fileio_spill_free,
+                    NULL, true, true);
     // END INTERFACE INITIALIZATION
 
     // create a thread to poll for fileio
@@ -49,19 +49,21 @@ are "expanded" round-robin to fill the available output channels.
 Otherwise, extra output channels are zero-filled and extra input
 channels are discarded. This sends a request to the fileio service:
 
-    /fileio/fileplay/new "hsffB" addr filename start end cycle
+    /fileio/fileplay/new "hsffBi" addr filename start end cycle skip
 
 where addr is the address of the Fileplay instance. (It is tempting
 to send id, but if the Fileplay is freed by the client, then the id
 will no longer work. See "References and reference counting" in
-fileplay.h.
+fileplay.h. skip is the number of frames after start that the reader
+should skip because Fileplay already has them in a primed head (see
+"Primed files" below); normally skip is 0.
 
 When the file is opened, the first buffer is read and sent (see
 /arco/fileplay/samps) and then a ready message is sent:
 
-    /arco/fileplay/ready "hiB" addr chans ready
+    /arco/fileplay/ready "hiBi" addr chans ready samplerate
 
-If the file could not be opened, chans is 0. Otherwise chans is the
+If the file could not be opened, chans and samplerate are 0. Otherwise chans is the
 actual number of channels in the file. The number of channels returned
 in Audioblocks will be this number, independent of the actual channels
 output by the unit generator. If the start time requested is beyond
@@ -83,6 +85,23 @@ request to refill with the next block of samples from the file:
 
     /fileio/fileplay/read "h" addr
 
+This also releases the oldest Audioblock held by Fileplay, which the
+reader will reuse. Readers of compressed files (FLAC, Ogg, MP3) decode
+blocks ahead of these requests whenever the fileio thread polls, so
+that expensive decoding does not delay the reply (see "Decode-ahead"
+in fileio.cpp). To get decode statistics for a stream:
+
+    /fileio/fileplay/stats "hsi" addr reply_addr id
+
+which replies with:
+
+    reply_addr "isiiff" id codec ahead blocks mean_ms max_ms
+
+where codec is "pcm", "flac", "ogg" or "compressed", ahead is the
+current number of blocks decoded in advance, blocks is the number of
+blocks decoded so far, and mean_ms and max_ms are the mean and
+maximum time to decode one block in milliseconds.
+
 The reply with the block of samples is:
 
     /arco/fileplay/samps "hh" addr address
@@ -98,11 +117,36 @@ This can be asynchronous with respect to file reading, so it is
 possible for Arco to then receive an /arco/fileplay/samps
 message. However, eventually, a reply will be sent:
 
-    /arco/fileplay/ready "hiB" addr chans ready (= false)
+    /arco/fileplay/ready "hiBi" addr chans ready (= false) samplerate
 
 which indicates the Fileio_obj has been deleted and no further
 messages will follow for addr.
 
+Primed files
+------------
+
+To keep the beginning of a file resident in memory so that Fileplay
+can start without waiting for the file to be opened:
+
+    /arco/fileplay/prime "sf" filename dur
+
+The audio thread records a pending entry for filename and sends:
+
+    /fileio/fileplay/prime "sf" filename dur
+
+The fileio thread reads the first dur seconds of the file into an
+Audioblock sized for exactly that many frames and replies:
+
+    /arco/fileplay/primed "shi" filename address samplerate
+
+where address is the Audioblock or 0 if the file could not be read.
+The Audioblock last flag is set if it contains the whole file. The
+block is then owned by the audio thread until:
+
+    /arco/fileplay/unprime "s" filename
+
+which frees the block as soon as no Fileplay is playing from it.
+
 To shut down the entire fileio bridge and thread:
 
     /fileio/quit ""
@@ -143,6 +187,33 @@ messages for addr are sent.
 There is no final /arco/filerec/ready with ready == false; instead
 there is /arco/filerec/samps with the last flag set.
 
+Spilling
+--------
+
+A Recplay with spill enabled keeps buffers of float samples in a
+temporary file (see recplay.cpp). The file is created with:
+
+    /fileio/spill/new "hii" addr chans samples
+
+where samples is the number of samples per buffer. Each channel of
+a buffer is written and read separately:
+
+    /fileio/spill/write "hiih" addr chan buffer samps
+    /fileio/spill/read "hii" addr chan buffer
+
+The replies are:
+
+    /arco/recplay/written "hiiB" addr chan buffer ok
+    /arco/recplay/paged "hiih" addr chan buffer samps
+
+Written samples remain owned by Recplay. Samples read are newly
+allocated and become owned by Recplay. To close the file:
+
+    /fileio/spill/free "h" addr
+
+which replies with /arco/recplay/unspilled "h" addr. This is the last
+message for addr.
+
 */
 
 int fileio_initialize();
@@ -162,7 +233,7 @@ public:
 
     Fileio_obj(int64_t addr_) { addr = addr_; };
 
-    ~Fileio_obj() { 
+    virtual ~Fileio_obj() { 
         for (int i = 0; i < fileio_objs.size(); i++) {
             if (fileio_objs[i] == this) {
                 fileio_objs.remove(i);
@@ -170,6 +241,9 @@ public:
             }
         }
     }
+
+    // called every fileio polling period, e.g. to decode ahead:
+    virtual void poll() { }
 };
 
 
@@ -9,10 +9,16 @@
 #include "sharedmem.h"
 #include "const.h"
 #include "audioblock.h"
+#include "resamp.h"
 #include "fileplay.h"
 
 const char *Fileplay_name = "Fileplay";
 
+// primed file heads, see "Primed files" in fileplay.h. This is only
+// accessed from the audio thread, so there are few enough primed
+// files that linear search is fine.
+static Vec<Fileplay_prime *> fileplay_primes;
+
 void send_fileplay_start(int64_t addr, bool play_flag)
 {
     // o2sm_send_cmd("/fileio/fileplay/start", 0, "hB", addr, play_flag);
@@ -30,6 +36,64 @@ Fileplay::~Fileplay()
     if (!stopped) {
         send_fileplay_start((int64_t) this, false);
     }
+    if (prime) {
+        fileplay_prime_release(prime);
+    }
+}
+
+
+// find index of prime for filename, including removed and pending
+// entries, or return -1:
+static int fileplay_prime_index(const char *filename)
+{
+    for (int i = 0; i < fileplay_primes.size(); i++) {
+        if (strcmp(fileplay_primes[i]->filename, filename) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+// free prime at index i if it is removed and no longer in use:
+static void fileplay_prime_cleanup(int i)
+{
+    Fileplay_prime *prime = fileplay_primes[i];
+    if (!prime->removed || prime->users > 0) {
+        return;
+    }
+    if (prime->head) {
+        O2_FREE(prime->head);
+    }
+    O2_FREE(prime->filename);
+    O2_FREE(prime);
+    fileplay_primes.remove(i);
+}
+
+
+Fileplay_prime *fileplay_prime_find(const char *filename)
+{
+    int i = fileplay_prime_index(filename);
+    if (i < 0) {
+        return NULL;
+    }
+    Fileplay_prime *prime = fileplay_primes[i];
+    if (prime->removed || !prime->head) {
+        return NULL;  // unprimed or still loading
+    }
+    return prime;
+}
+
+
+void fileplay_prime_release(Fileplay_prime *prime)
+{
+    prime->users--;
+    for (int i = 0; i < fileplay_primes.size(); i++) {
+        if (fileplay_primes[i] == prime) {
+            fileplay_prime_cleanup(i);
+            return;
+        }
+    }
 }
 
 
@@ -74,7 +138,8 @@ void arco_fileplay_samps(O2SM_HANDLER_ARGS)
 }
 
 
-/* O2SM INTERFACE: /arco/fileplay/ready int64 addr, int32 chans, bool ready;
+/* O2SM INTERFACE: /arco/fileplay/ready int64 addr, int32 chans, bool ready,
+       int32 samplerate;
  */
 void arco_fileplay_ready(O2SM_HANDLER_ARGS)
 {
@@ -82,10 +147,11 @@ void arco_fileplay_ready(O2SM_HANDLER_ARGS)
     int64_t addr = argv[0]->h;
     int32_t chans = argv[1]->i;
     bool ready = argv[2]->B;
+    int32_t samplerate = argv[3]->i;
     // end unpack message
 
     Fileplay *fileplay = (Fileplay *) addr;
-    fileplay->ready(ready);
+    fileplay->ready(ready, samplerate);
 }
 
 
@@ -103,13 +169,133 @@ void arco_fileplay_start(O2SM_HANDLER_ARGS)
 }
 
 
+/* O2SM INTERFACE: /arco/fileplay/speed int32 id, float speed;
+ */
+void arco_fileplay_speed(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    float speed = argv[1]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Fileplay, fileplay, id, "arco_fileplay_speed");
+    fileplay->set_speed(speed);
+}
+
+
+/* O2SM INTERFACE: /arco/fileplay/stats int32 id, string reply_addr;
+ */
+void arco_fileplay_stats(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    char *reply_addr = argv[1]->s;
+    // end unpack message
+
+    UGEN_FROM_ID(Fileplay, fileplay, id, "arco_fileplay_stats");
+    fileplay->stats(reply_addr);
+}
+
+
+/* O2SM INTERFACE: /arco/fileplay/prime string filename, float dur;
+   Load the first dur seconds of filename into memory so that Fileplay
+   can start immediately without waiting for the file to be opened.
+ */
+void arco_fileplay_prime(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    char *filename = argv[0]->s;
+    float dur = argv[1]->f;
+    // end unpack message
+
+    int i = fileplay_prime_index(filename);
+    if (i >= 0) {  // already primed or loading; cancel any pending unprime
+        fileplay_primes[i]->removed = false;
+        return;
+    }
+    Fileplay_prime *prime = O2_MALLOCT(Fileplay_prime);
+    int len = (int) strlen(filename);
+    prime->filename = O2_MALLOCNT(len + 1, char);
+    memcpy(prime->filename, filename, len + 1);
+    prime->head = NULL;
+    prime->samplerate = 0;
+    prime->users = 0;
+    prime->removed = false;
+    fileplay_primes.push_back(prime);
+
+    // o2sm_send_cmd("/fileio/fileplay/prime", 0, "sf", filename, dur);
+    o2_send_start();
+    o2_add_string(filename);
+    o2_add_float(dur);
+    O2message_ptr iomsg = o2_message_finish(0.0, "/fileio/fileplay/prime",
+                                            true);
+    o2_shmem_inst_outgoing_push(fileio_bridge, (O2list_elem *) iomsg);
+}
+
+
+/* O2SM INTERFACE: /arco/fileplay/primed
+       string filename, int64 ablock, int32 samplerate;
+   Reply from fileio with the head of filename (ablock is 0 on failure).
+ */
+void arco_fileplay_primed(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    char *filename = argv[0]->s;
+    int64_t ablock = argv[1]->h;
+    int32_t samplerate = argv[2]->i;
+    // end unpack message
+
+    Audioblock *head = (Audioblock *) ablock;
+    int i = fileplay_prime_index(filename);
+    Fileplay_prime *prime = (i >= 0 ? fileplay_primes[i] : NULL);
+    if (prime && !prime->head && !prime->removed && head) {
+        prime->head = head;
+        prime->samplerate = samplerate;
+        return;
+    }
+    if (head) {  // not wanted anymore
+        O2_FREE(head);
+    } else {
+        arco_warn("Fileplay - failure to prime %s", filename);
+    }
+    if (prime && !prime->head) {  // failed or unprimed before loading
+        prime->removed = true;
+        fileplay_prime_cleanup(i);
+    }
+}
+
+
+/* O2SM INTERFACE: /arco/fileplay/unprime string filename;
+   Free the primed head of filename once no Fileplay is using it.
+ */
+void arco_fileplay_unprime(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    char *filename = argv[0]->s;
+    // end unpack message
+
+    int i = fileplay_prime_index(filename);
+    if (i >= 0) {
+        fileplay_primes[i]->removed = true;
+        if (fileplay_primes[i]->head) {  // otherwise, wait for primed
+            fileplay_prime_cleanup(i);
+        }
+    }
+}
+
+
 static void fileplay_init()
 {
     // O2SM INTERFACE INITIALIZATION: (machine generated)
     o2sm_method_new("/arco/fileplay/new", "iisffBBB", arco_fileplay_new, NULL, true, true);
     o2sm_method_new("/arco/fileplay/samps", "hh", arco_fileplay_samps, NULL, true, true);
-    o2sm_method_new("/arco/fileplay/ready", "hiB", arco_fileplay_ready, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/ready", "hiBi", arco_fileplay_ready, NULL, true, true);
     o2sm_method_new("/arco/fileplay/start", "iB", arco_fileplay_start, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/speed", "if", arco_fileplay_speed, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/stats", "is", arco_fileplay_stats, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/prime", "sf", arco_fileplay_prime, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/primed", "shi", arco_fileplay_primed, NULL, true, true);
+    o2sm_method_new("/arco/fileplay/unprime", "s", arco_fileplay_unprime, NULL, true, true);
     // END INTERFACE INITIALIZATION
 }
 
@@ -38,15 +38,76 @@ confirmation, when we can delete the Fileplay object. The Fileio_obj
 is deleted with an /fileio/fileplay/play message (play = false). The
 confirmation message is /arco/fileplay/ready (ready = false).
 
+Primed files:
+
+Fileplay cannot produce sound until the Fileio_reader has opened the
+file and delivered its first Audioblock, which takes at least one
+fileio polling period. To trigger samples without this latency, a
+file can be "primed" with /arco/fileplay/prime: the fileio thread
+reads the first frames of the file into an Audioblock (the "head")
+that stays resident in a table of Fileplay_prime entries owned by the
+audio thread. A Fileplay created with start = 0 on a primed file
+plays the head immediately and asks the Fileio_reader to skip the
+frames covered by the head, so the streamed blocks only need to
+arrive before the head is used up. The head is shared by all Fileplay
+instances on that file, so each entry counts its users, and
+/arco/fileplay/unprime only frees the head when no Fileplay is
+playing from it.
+
+Speed and sample rate conversion:
+
+Files play at the correct pitch regardless of their sample rate, and
+/arco/fileplay/speed changes the playback speed (and pitch) by a
+factor. The file sample rate comes from the primed head or from the
+/arco/fileplay/ready message. Together these give period, the number
+of file frames per output sample: speed * file sample rate / AR. When
+period is exactly 1, frames are copied directly to the output as
+before. Otherwise, frames are copied from Audioblocks into src, a
+short per-channel history, and resampled with a windowed sinc filter
+of FILEPLAY_SPAN points (a Resamp, see cmupv/src/resamp.h), which is
+scaled to low-pass filter when period > 1. src keeps FILEPLAY_KEEP
+frames before the read position, enough for the filter at the
+highest period, FILEPLAY_MAX_PERIOD. src and the filter bank are
+allocated by the constructor, so speed changes do not allocate. While
+frames are copied directly, the last FILEPLAY_KEEP output frames are
+kept in src so that resampling continues smoothly from them when the
+speed changes. Once resampling has started,
+Fileplay keeps resampling even if period returns to 1, since src
+holds frames that have not been played yet. For the same reason,
+when resampling, ACTION_END is sent after the frames in src have been
+played rather than when the reader reaches the end of the file.
+
 */
 
 #define FILEPLAY_DEBUG 0
 
+#define FILEPLAY_SPAN 32
+#define FILEPLAY_MAX_PERIOD 8.0
+#define FILEPLAY_KEEP (FILEPLAY_SPAN / 2 * (int) FILEPLAY_MAX_PERIOD + 2)
+// frames per channel in src: history, one block, and the right half of
+// the filter at the highest period:
+#define FILEPLAY_SRC_LEN (2 * FILEPLAY_KEEP + (int) (BL * FILEPLAY_MAX_PERIOD))
+
 extern const char *Fileplay_name;
 extern void *fileio_bridge;
 
 void send_fileplay_start(int64_t addr, bool play_flag);
 
+// a primed file head shared by Fileplay instances (see "Primed files")
+struct Fileplay_prime {
+    char *filename;
+    Audioblock *head;  // first frames of the file, NULL until loaded
+    int samplerate;  // sample rate of the file, used to apply end time
+    int users;  // how many Fileplay instances are playing from head
+    bool removed;  // unprimed; free head when users goes to zero
+};
+
+// find a loaded and not-removed prime for filename, or return NULL:
+Fileplay_prime *fileplay_prime_find(const char *filename);
+
+// called by Fileplay when it is finished with prime->head:
+void fileplay_prime_release(Fileplay_prime *prime);
+
 class Fileplay : public Ugen {
 public:
     bool started;  // has been started
@@ -57,7 +118,20 @@ public:
     int next_block;  // where to put next block from reader
     bool mix;
     bool expand;
+    bool cycle;
+    Fileplay_prime *prime;  // if non-NULL, play from prime->head first
+    int head_frames;  // how many frames of prime->head to play
+    bool head_is_all;  // head covers everything from start to end
     int action_id;  // send this when playback is stopped or finished
+    float speed;     // playback speed factor
+    int file_sr;     // sample rate of the file, 0 if not yet known
+    bool resampling; // src is in use (see "Speed and sample rate ...")
+    Vec<Sample> src; // chans * FILEPLAY_SRC_LEN frames of file history
+    int src_frames;  // frames in src (per channel)
+    int src_end;     // frames in src before end of file, or -1
+    double src_offset;  // position in src of the next output sample
+    bool end_pending;   // send ACTION_END after src is played
+    Resamp resamp;
 #if FILEPLAY_DEBUG
     int blocks_requested;
     int blocks_received;
@@ -75,19 +149,56 @@ public:
         blocks[1] = NULL;
         frame_in_block = 0;
         action_id = 0;
+        this->cycle = cycle;
+        prime = NULL;
+        head_frames = 0;
+        head_is_all = false;
+        speed = 1;
+        file_sr = 0;
+        resampling = false;
+        src_frames = 0;
+        src_end = -1;
+        src_offset = 0;
+        end_pending = false;
+        resamp.init(FILEPLAY_SPAN, 32);
+        // allocate now so that speed changes do not allocate:
+        resamp.reserve_bank(FILEPLAY_MAX_PERIOD);
+        src.set_size(chans * FILEPLAY_SRC_LEN);  // zero fills
 #if FILEPLAY_DEBUG
         blocks_requested = 1;
         blocks_received = 0;
 #endif
+        // primed heads begin at time 0, so they only apply if start is 0:
+        if (start <= 0) {
+            prime = fileplay_prime_find(filename);
+        }
+        if (prime) {
+            head_frames = prime->head->frames;
+            head_is_all = prime->head->last;
+            if (end > 0) {
+                int end_frames = (int) (end * prime->samplerate);
+                if (end_frames <= head_frames) {
+                    head_frames = end_frames;
+                    head_is_all = true;
+                }
+            }
+            file_sr = prime->samplerate;
+            if (head_frames > 0) {
+                prime->users++;
+            } else {
+                prime = NULL;
+            }
+        }
 
-        // o2sm_send_cmd("/fileio/fileplay/new", 0, "hsffB", addr, filename,
-        //               start, end, cycle);
+        // o2sm_send_cmd("/fileio/fileplay/new", 0, "hsffBi", addr, filename,
+        //               start, end, cycle, head_frames);
         o2_send_start();
         o2_add_int64((int64_t) this);
         o2_add_string(filename);
         o2_add_float(start);
         o2_add_float(end);
         o2_add_bool(cycle);
+        o2_add_int32(head_frames);  // reader skips the frames in head
         O2message_ptr msg = o2_message_finish(0.0, "/fileio/fileplay/new",
                                               true);
         o2_shmem_inst_outgoing_push(fileio_bridge, (O2list_elem *) msg);
@@ -101,6 +212,9 @@ public:
             if (!stopped) {
                 start(false);
             } else {
+                if (end_pending) {  // src will never be played
+                    send_action_id(ACTION_END);
+                }
                 if (flags & UGENTRACE) {
                     ahprintf("Fileplay::unref deleting traced ugen: ");
                     print();
@@ -123,8 +237,9 @@ public:
 
 
     void print_details(int indent) {
-        arco_print("started %s stopped %s action %d",
-                   btos(started), btos(stopped), action_id);
+        arco_print("started %s stopped %s action %d primed %s speed %g "
+                   "file_sr %d", btos(started), btos(stopped), action_id,
+                   btos(prime), speed, file_sr);
     }
 
 
@@ -134,7 +249,7 @@ public:
             started = true;
         } else if (!play && !stopped) { // you can stop before play starts!
             stopped = true;
-            send_action_id(ACTION_END);
+            send_end();
         } else {
             return;
         }
@@ -144,16 +259,33 @@ public:
     }
 
 
+    // Send ACTION_END, but if resampling, src holds frames that have
+    // not been output yet, so wait until run_resampled() plays them.
+    void send_end() {
+        if (resampling) {
+            end_pending = true;
+        } else {
+            send_action_id(ACTION_END);
+        }
+    }
+
+
     // this is a notice from Fileio that it is ready to start.
-    void ready(bool is_ready) {
+    void ready(bool is_ready, int samplerate) {
+        if (samplerate > 0) {
+            file_sr = samplerate;
+        }
         if (!is_ready && !started) {
             arco_warn("Fileplay - failure to start reading from file");
             send_action_id(ACTION_ERROR);
         }
         if (!is_ready) {  // there is nothing more to read
             stopped = true;
-            send_action_id(ACTION_END);
+            send_end();
             if (refcount == 0) {
+                if (end_pending) {  // src will never be played
+                    send_action_id(ACTION_END);
+                }
                 // ahprintf("Fileplay::ready deleting %p\n", this);
                 delete this;
             }
@@ -161,6 +293,40 @@ public:
     }
 
     
+    // ask the reader to send decode statistics to reply_addr. Once
+    // playback has finished or been stopped, the reader may be gone,
+    // so there is no reply:
+    void stats(const char *reply_addr) {
+        if (stopped && !end_pending) {
+            return;
+        }
+        // o2sm_send_cmd("/fileio/fileplay/stats", 0, "hsi", addr,
+        //               reply_addr, id);
+        o2_send_start();
+        o2_add_int64((int64_t) this);
+        o2_add_string(reply_addr);
+        o2_add_int32(id);
+        O2message_ptr msg = o2_message_finish(0.0, "/fileio/fileplay/stats",
+                                              true);
+        o2_shmem_inst_outgoing_push(fileio_bridge, (O2list_elem *) msg);
+    }
+
+
+    void set_speed(float s) {
+        speed = MAX(s, 0.0f);
+    }
+
+
+    // file frames per output sample, limited to FILEPLAY_MAX_PERIOD:
+    double period() {
+        double p = speed;
+        if (file_sr > 0) {
+            p = p * file_sr / AR;
+        }
+        return MIN(p, FILEPLAY_MAX_PERIOD);
+    }
+
+
     void set_action_id(int id) {
         action_id = id;
         if (stopped) {
@@ -180,7 +346,33 @@ public:
     }
 
 
+    // the block we are playing from: the primed head, if any, comes first
+    Audioblock *playing_block() {
+        return prime ? prime->head : blocks[block_on_deck];
+    }
+
+
+    // how many frames of playing_block() to play:
+    int playing_frames() {
+        return prime ? head_frames : blocks[block_on_deck]->frames;
+    }
+
+
     Audioblock *advance_to_next_block() {
+        frame_in_block = 0;
+        if (prime) {  // done with the head, continue with streamed blocks
+            fileplay_prime_release(prime);
+            prime = NULL;
+            if (head_is_all && !cycle) {
+                start(false);
+                return NULL;
+            }
+            Audioblock *block = blocks[block_on_deck];
+            if (!block && !stopped) {
+                arco_warn("fileplay underflow after primed head");
+            }
+            return block;
+        }
         if (blocks[block_on_deck]->last) {  // not end of file
             start(false);
         } else if (!stopped) {
@@ -208,36 +400,40 @@ public:
 #endif
 
         }
-        frame_in_block = 0;
         return block;
     }
 
 
-    void real_run() {
-        Audioblock *block = blocks[block_on_deck];
+    // copy up to n frames from the file to dst, where channel ch goes
+    // to dst + ch * stride, filling with zeros after the end of the
+    // available input. Returns the number of frames taken from the file.
+    int read_frames(Sample_ptr dst, int stride, int n) {
+        Audioblock *block = playing_block();
         if (!started || stopped || !block) {
-            block_zero_n(out_samps, chans);
-            return;
+            for (int ch = 0; ch < chans; ch++) {
+                memset(dst + ch * stride, 0, n * sizeof(Sample));
+            }
+            return 0;
         }
         int i = 0;  // how many frames we have computed so far
         // how many channels to copy from input to output:
         int nchans = MIN(chans, block->channels);
 
-        while (i < BL) {  // may execute 2x to read from next block
+        while (i < n) {  // may execute 2x to read from next block
             if (!block) {  // zero the remaining output frames
                 for (int ch = 0; ch < nchans; ch++) {
-                    float *out = out_samps + ch * BL + i;
-                    for (int j = i; j < BL; j++) {
+                    float *out = dst + ch * stride + i;
+                    for (int j = i; j < n; j++) {
                         *out++ = 0;
                     }
                 }
                 break;
             }
-            int nframes = MIN(BL - i, block->frames - frame_in_block);
+            int nframes = MIN(n - i, playing_frames() - frame_in_block);
             int16_t *in_base_ptr = &(block->dat[
-                    (frame_in_block + i ) * block->channels]);
+                    frame_in_block * block->channels]);
             for (int ch = 0; ch < nchans; ch++) {
-                float *out = out_samps + ch * BL + i; // output not interleaved
+                float *out = dst + ch * stride + i; // output not interleaved
                 int16_t *inptr = in_base_ptr + ch;
                 for (int f = 0; f < nframes; f++) {
                     *out++ = INT16_TO_FLOAT(*inptr);
@@ -248,7 +444,7 @@ public:
             if (mix) {
                 for (int ch = chans; ch < block->channels; ch++) {
                     int outch = ch % chans;
-                    float *out = out_samps + outch * BL + i;
+                    float *out = dst + outch * stride + i;
                     int16_t *inptr = in_base_ptr + ch;
                     for (int f = 0; f < nframes; f++) {
                         *out++ += INT16_TO_FLOAT(*inptr);
@@ -258,7 +454,7 @@ public:
             }
             frame_in_block += nframes;
             i += nframes;
-            if (frame_in_block == block->frames) {
+            if (frame_in_block == playing_frames()) {
                 block = advance_to_next_block();
             }
         }
@@ -267,17 +463,91 @@ public:
             if (expand) {  // copy from earlier channels because
                            // block->chans < chans
                 for (int ch = nchans; ch < chans; ch++) {
-                    float *out = out_samps + ch * BL;
-                    float *src = out_samps + (ch % nchans) * BL;
-                    block_copy(out, src);
+                    memcpy(dst + ch * stride, dst + (ch % nchans) * stride,
+                           n * sizeof(Sample));
                 }
             } else {  // don't "expand" input; instead, fill with zeros
                 for (int ch = nchans; ch < chans; ch++) {
-                    float *out = out_samps + ch * BL;
-                    block_zero(out);
+                    memset(dst + ch * stride, 0, n * sizeof(Sample));
                 }
             }
         }
+        return i;
+    }
+
+
+    // compute a block by resampling src (see "Speed and sample rate
+    // conversion" above):
+    void run_resampled(double period) {
+        if (!resampling) {  // src holds the last FILEPLAY_KEEP frames
+            src_frames = FILEPLAY_KEEP;
+            src_offset = FILEPLAY_KEEP;
+            resampling = true;
+        }
+        double scale = MAX(1.0, period);
+        double half = scale * (FILEPLAY_SPAN / 2);
+        if (!started || (stopped && (src_end < 0 || 
+                                     src_offset - half >= src_end))) {
+            block_zero_n(out_samps, chans);
+            if (end_pending) {  // src has been played
+                end_pending = false;
+                send_action_id(ACTION_END);
+            }
+            return;
+        }
+        // read frames through the right edge of the last output window:
+        int need = (int) (src_offset + (BL - 1) * period + half) + 1;
+        if (need > src_frames) {
+            bool was_stopped = stopped;
+            int got = read_frames(&src[src_frames], FILEPLAY_SRC_LEN,
+                                  need - src_frames);
+            if (stopped && !was_stopped) {  // reached the end of the file
+                src_end = src_frames + got;
+            }
+            src_frames = need;
+        }
+        for (int ch = 0; ch < chans; ch++) {
+            resamp.resamp(out_samps + ch * BL, BL, &src[ch * FILEPLAY_SRC_LEN],
+                          src_offset, scale, period);
+        }
+        src_offset += BL * period;
+        // slide src to keep FILEPLAY_KEEP frames before src_offset:
+        int drop = (int) src_offset - FILEPLAY_KEEP;
+        if (drop > 0) {
+            for (int ch = 0; ch < chans; ch++) {
+                Sample *s = &src[ch * FILEPLAY_SRC_LEN];
+                memmove(s, s + drop, (src_frames - drop) * sizeof(Sample));
+            }
+            src_frames -= drop;
+            src_offset -= drop;
+            if (src_end >= 0) {
+                src_end -= drop;
+            }
+        }
+    }
+
+
+    // keep the last FILEPLAY_KEEP output frames of each channel at the
+    // start of src in case resampling starts (initially zeros):
+    void keep_history() {
+        int n = MIN(BL, FILEPLAY_KEEP);
+        for (int ch = 0; ch < chans; ch++) {
+            Sample *s = &src[ch * FILEPLAY_SRC_LEN];
+            memmove(s, s + n, (FILEPLAY_KEEP - n) * sizeof(Sample));
+            memcpy(s + FILEPLAY_KEEP - n, out_samps + ch * BL + BL - n,
+                   n * sizeof(Sample));
+        }
+    }
+
+
+    void real_run() {
+        double p = period();
+        if (p == 1.0 && !resampling) {
+            read_frames(out_samps, BL, BL);
+            keep_history();
+        } else {
+            run_resampled(p);
+        }
     }
 };
 
@@ -41,6 +41,8 @@
 
 
 #include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
 #include "fastrand.h"
 #include "ringbuf.h"
 #include "dcblock.h"
@@ -55,6 +57,9 @@ const char *Granstream_name = "Granstream";
 // declared here to break circular references among classes
 //
 bool Granstream_state::chan_a(Granstream *gs, Sample *out_samps, int chan) {
+    if (grow_pool) {  // waiting to grow input_buf
+        grow();
+    }
     // first, read input audio into input buffer
     input_buf.enqueue_block(gs->input_samps);
     // if feedback enabled, add feedback from delay buffer:
@@ -71,19 +76,20 @@ bool Granstream_state::chan_a(Granstream *gs, Sample *out_samps, int chan) {
             // is < 1, dividing by density will produce very high feedback
             // amplitudes that will clip, hence the use of fmax(1.0, ...):
             Sample target = gs->feedback / fmax(1.0, sqrt(gs->density));
+            Sample fb[BL];
+            feedback_buf.dequeue_block(fb);
             for (int i = 0; i < BL; i++) {
                 gs->feedback_out_smoothed = target +
                         gs->feedbackfactor *
                         (gs->feedback_out_smoothed - target);
-                Sample fb = feedback_buf.dequeue() * gs->feedback_out_smoothed;
-                fb = gs->dcblock.filter(fb);
-                input_buf.add_to_nth(fb, BL - i);
+                fb[i] = gs->dcblock.filter(fb[i] * gs->feedback_out_smoothed);
 #ifdef SEEFB
-                out_samps[i] = fb * 0.1;  // force chan 1 to be just feedback
+                out_samps[i] = fb[i] * 0.1;  // force chan 1 to be just feedback
                 // scaled by 0.1 because we want to see the waveform even when
                 // it is out of [-1, +1] range
 #endif
             }
+            input_buf.add_to_last(fb);
             D ahprintf("fbgain %g\n", gs->feedback_out_smoothed);
         } else {  // need to remove samples from input_buf in any case
             input_buf.toss(BL);
@@ -110,11 +116,71 @@ bool Granstream_state::chan_a(Granstream *gs, Sample *out_samps, int chan) {
 }
 
 
+// Render one block of this grain into out_samps. This is the inner loop
+// of Granstream, so it is written to let the compiler vectorize: the
+// read position in input_buf almost never wraps within a block, so we
+// use a pointer into the contiguous span of samples (rather than
+// get_nth() for every sample), gather samples into grain[], then apply
+// the linear envelope in closed form while accumulating to the output.
+//
+void Gran_gen::render(Ringbuf &input_buf, Sample_ptr out_samps)
+{
+    Sample grain[BL];
+    // phase decreases by ratio per sample, so we read from
+    // get_nth(first + 1) (for interpolation) to get_nth(last):
+    int first = (int) phase;
+    int last = (int) (phase - (BL - 1) * ratio);
+    int lo = (input_buf.tail - first - 1) & input_buf.mask;
+    if (lo + (first + 1 - last) < input_buf.size()) {  // no wrap
+        // get_nth(n) == src[-n] for last <= n <= first + 1:
+        Sample *src = &input_buf[lo] + first + 1;
+        if (ratio == 1.0) {  // no tranposition, phase is integral
+            Sample *s = src - first;
+            for (int i = 0; i < BL; i++) {
+                grain[i] = s[i];
+            }
+        } else {  // for tranposition, phase is fractional
+            double ph = phase;  // so do linear interpolation
+            for (int i = 0; i < BL; i++) {
+                int n = (int) ph;
+                Sample x = src[-n];
+                grain[i] = x + (Sample) (ph - n) * (src[-n - 1] - x);
+                ph -= ratio;
+            }
+        }
+    } else {  // the span wraps around the end of input_buf
+        double ph = phase;
+        for (int i = 0; i < BL; i++) {
+            int n = (int) ph;
+            Sample x = input_buf.get_nth(n);
+            if (ratio != 1.0) {
+                x += (Sample) (ph - n) * (input_buf.get_nth(n + 1) - x);
+            }
+            grain[i] = x;
+            ph -= ratio;
+        }
+    }
+    Sample env = env_val;
+    Sample inc = env_inc;
+    for (int i = 0; i < BL; i++) {
+        out_samps[i] += grain[i] * (env + (i + 1) * inc);
+    }
+    env_val += BL * env_inc;
+    phase -= BL * ratio;  // tricky - on average, the phase really
+    // advances by (ratio - 1) each sample, but since the tail
+    // got added to buf in a block and not while we're rendering, we
+    // have to advance by ratio. Also, phase is how far *back* we
+    // access, so to advance in the buffer, we have to decrease phase,
+    // hence -= instead of +=.
+}
+
+
 bool Gran_gen::run(Granstream *gs, Granstream_state *perchannel,
                    Sample_ptr out_samps, int chan, int index) {
     int bufferlen = perchannel->input_buf.get_fifo_len();
     if (--delay == 0) {
         switch (state) {
+          case GS_SKIP:  // a skipped grain would have finished here
           case GS_FALL: {  // fall has finished, now at end of envelope
             env_val = 0;
             env_inc = 0;
@@ -218,6 +284,15 @@ bool Gran_gen::run(Granstream *gs, Granstream_state *perchannel,
             // it may be that we can't satisfy both constraints, 
             // so check again. Also, make sure phase is initially 
             // in buffer. Only play grain if it is possible:
+            if (gs->grain_budget > 0 &&
+                MAX(gs->grains_prev, gs->grains) >= gs->grain_budget) {
+                // over budget: skip this grain and schedule another as if
+                // this one had played, reducing density (see set_budget())
+                gs->grains_skipped++;
+                state = GS_SKIP;
+                delay = dur_blocks;
+                return false;
+            }
             if (phase < bufferlen - BL && final_phase < bufferlen - BL &&
                 phase > BL && final_phase > BL) {
                 // start the note
@@ -262,7 +337,7 @@ bool Gran_gen::run(Granstream *gs, Granstream_state *perchannel,
             break;
         }
     }
-    if (state != GS_PREDELAY) {  // envelope is non-zero
+    if (state != GS_PREDELAY && state != GS_SKIP) {  // envelope is non-zero
         assert(perchannel->input_buf.bounds_check((int) phase));
         Sample ampl;
         // non-standard output: Instead of each channel (perchannel)
@@ -279,26 +354,11 @@ bool Gran_gen::run(Granstream *gs, Granstream_state *perchannel,
         assert(gs->chans > 1);  // SEEFB requires at least 2 channels
         out_samps += BL * ((chan + index) % (gs->chans - 1));
 #endif
-        for (int i = 0; i < BL; i++) {
-            int index = (int) phase;
-            Sample x = perchannel->input_buf.get_nth(index);
-            if (ratio != 1.0) {  // for tranposition, phase is fractional
-                int index2 = index + 1;  // so do linear interpolation
-                Sample x2 = perchannel->input_buf.get_nth(index2);
-                x += (phase - index) * (x2 - x);
-            }
-            env_val += env_inc;
-            *out_samps++ += x * env_val;
-            phase -= ratio;  // tricky - on average, the phase really
-            // advances by (ratio - 1) each sample, but since the tail
-            // got added to buf in a block and not while we're in this
-            // loop, we have to advance by ratio. Also, phase is how far
-            // *back* we access, so to advance in the buffer, we have to
-            // decrease phase, hence -= instead of +=.
-        }
+        render(perchannel->input_buf, out_samps);
         phase += BL;  // before we are called back, BL samples will be
         // inserted at the tail, so we need to bump phase by BL so that
         // it will reference the same location in time.
+        gs->grains++;
         return true;  // this grain is active
     }
     return false;  // this grain is not active
@@ -474,6 +534,20 @@ static void arco_granstream_env(O2SM_HANDLER_ARGS)
 }
 
 
+/* O2SM INTERFACE: /arco/granstream/budget int32 id, int32 max_grains;
+ */
+static void arco_granstream_budget(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t max_grains = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Granstream, granstream, id, "arco_granstream_budget");
+    granstream->set_budget(max_grains);
+}
+
+
 /* O2SM INTERFACE: /arco/granstream/enable int32 id, bool enable;
  */
 static void arco_granstream_enable(O2SM_HANDLER_ARGS)
@@ -513,6 +587,8 @@ static void granstream_init()
                     NULL, true, true);
     o2sm_method_new("/arco/granstream/env", "iff", arco_granstream_env, NULL,
                     true, true);
+    o2sm_method_new("/arco/granstream/budget", "ii", arco_granstream_budget,
+                    NULL, true, true);
     o2sm_method_new("/arco/granstream/enable", "iB", arco_granstream_enable,
                     NULL, true, true);
     // END INTERFACE INITIALIZATION
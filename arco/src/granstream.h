@@ -60,7 +60,9 @@ extern const char *Granstream_name;
 class Granstream;
 class Granstream_state;
 
-enum Gran_state {GS_PREDELAY, GS_RISE, GS_HOLD, GS_FALL};
+// GS_SKIP is silent, lasting as long as a grain skipped because of the
+// grain budget would have played; then it acts like the end of GS_FALL:
+enum Gran_state {GS_PREDELAY, GS_RISE, GS_HOLD, GS_FALL, GS_SKIP};
 
 // a Gran_gen manages a single grain; there are polyphony of these per
 // channel, stored in the per-channel state called Granstream_state;
@@ -93,6 +95,8 @@ public:
     // returns true if grain is active
     bool run(Granstream *gs, Granstream_state *perchannel,
              Sample_ptr out_samps, int chan, int index);
+
+    void render(Ringbuf &input_buf, Sample_ptr out_samps);
 };
 
 
@@ -101,9 +105,16 @@ public:
     Ringbuf input_buf;   // input buffer (source for grains)
     Vec<Gran_gen> gens;  // individual grains
     int actual_polyphony;  // how many grains to we have to run/are running?
+    // input_buf grows with storage from a Bufferpool (see bufferpool.h).
+    // While waiting for storage, grow_pool is non-NULL and grow_len is
+    // the requested length of input_buf:
+    Bufferpool *grow_pool;
+    int grow_len;
 
     void init(float dur, int polyphony) {
         int len = ((int) (dur * AR) + BL) & ~(BL - 1);  // round up to BL
+        grow_pool = NULL;
+        grow_len = 0;
         input_buf.init(len, true);
         gens.init(polyphony);  // size is now 0
         gens.set_size(polyphony, false);  // no need to zero fill
@@ -112,7 +123,9 @@ public:
     }
     
     void finish() {
-        input_buf.finish();
+        cancel_grow();
+        bufferpool_discard(input_buf.get_array());  // main thread will free
+        input_buf.init(0);  // forget the discarded array
         gens.finish();
     }
     
@@ -138,11 +151,44 @@ public:
         // reading from a long delay that would become inaccessible if the
         // buffer size is reduced. dur, however, can be reduced so that future
         // grains come from more recent history (lower delay).
-        if (len > input_buf.get_fifo_len()) {
+        if (len <= input_buf.get_fifo_len()) {
+            return;
+        }
+        cancel_grow();
+        Bufferpool *pool = NULL;
+        if (len >= input_buf.size()) {  // must grow the allocation
+            pool = bufferpool_pow2(input_buf.vec_len(len));
+        }
+        if (pool) {  // grow when the pool has a buffer, maybe right now
+            grow_pool = pool;
+            grow_len = len;
+            pool->reserve(1);
+            grow();
+        } else {  // no allocation, or too big for a pool
             input_buf.set_fifo_len(len, true);
             assert(input_buf.get_fifo_len() == len);
         }
     }
+
+    // try to complete a pending set_dur() with storage from grow_pool.
+    // Until then, grains are limited to the old buffer length.
+    void grow() {
+        Sample_ptr storage = grow_pool->get();
+        if (storage) {
+            bufferpool_discard(input_buf.set_fifo_len(grow_len, true, storage,
+                                                      grow_pool->samples));
+            assert(input_buf.get_fifo_len() == grow_len);
+            grow_pool->reserve(-1);
+            grow_pool = NULL;
+        }
+    }
+
+    void cancel_grow() {
+        if (grow_pool) {
+            grow_pool->reserve(-1);
+            grow_pool = NULL;
+        }
+    }
 };
 
 
@@ -184,6 +230,13 @@ public:
     int warning_block;  // used to limit rate of warning messages
     bool stop_request;  // waiting for last grain to finish before setting
                         // enable to false.
+    // CPU budget: rendering cost is proportional to the number of active
+    // grains, so we limit active grains (over all channels) to
+    // grain_budget by skipping grains that would exceed it:
+    int grain_budget;    // 0 means no limit
+    int grains;          // active grains counted so far in this block
+    int grains_prev;     // active grains in the previous block
+    int grains_skipped;  // grains not played because of the budget
     
     Granstream(int id, int nchans, Ugen_ptr input, int polyphony_,
                     float dur_, bool enable_) : Ugen(id, 'a', nchans) {
@@ -213,6 +266,10 @@ public:
         gain = 1.0;
         warning_block = 0;
         stop_request = false;
+        grain_budget = 0;
+        grains = 0;
+        grains_prev = 0;
+        grains_skipped = 0;
 
         states.set_size(chans, false);  // no zero because of following loop:
         for (int i = 0; i < chans; i++) {
@@ -250,6 +307,9 @@ public:
                    highdur, lowdur, density, attack, release);
         indent_spaces(indent + 2);
         arco_print("feedback %g", feedback);
+        indent_spaces(indent + 2);
+        arco_print("budget %d grains %d skipped %d",
+                   grain_budget, grains_prev, grains_skipped);
     }
 
     
@@ -317,6 +377,16 @@ public:
     }
 
 
+    // limit the number of active grains; a grain that would exceed the
+    // limit is skipped: its generator stays silent for the grain's
+    // duration and then waits the usual time before the next grain, so
+    // density is reduced rather than overloading the audio thread.
+    // 0 means no limit.
+    void set_budget(int max_grains) {
+        grain_budget = MAX(0, max_grains);
+    }
+
+
     void set_dur(float d) {
         dur = d;
         // because grains must be extracted from within the buffer, and the
@@ -360,6 +430,8 @@ public:
         // clear all output here because each channel (state) can sum grains
         // to each channel
         block_zero_n(out_samps, chans);
+        grains_prev = grains;
+        grains = 0;
         
         for (int i = 0; i < states.size(); i++) {
             active |= chan_a(state, i);
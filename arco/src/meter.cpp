@@ -0,0 +1,262 @@
+/* meter.cpp -- multichannel peak, RMS, true-peak and loudness meter
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "zero.h"
+#include "meter.h"
+
+const char *Meter_name = "Meter";
+
+
+// Compute the true-peak interpolator and K-weighting filters for AR.
+void Meter::init_filters()
+{
+    // phase p of the interpolator computes the signal at 1/4 * (p + 1)
+    // of the way from one input sample to the next from the last 12
+    // inputs, using a Hann-windowed sinc:
+    for (int p = 0; p < METER_TP_PHASES; p++) {
+        float sum = 0;
+        for (int k = 0; k < METER_TP_TAPS; k++) {
+            // tap k multiplies the input k samples before the newest
+            double t = k - (METER_TP_TAPS / 2 - 1) -
+                       (double) (p + 1) / METER_TP_PHASES;
+            double x = M_PI * t;
+            double sinc = (t == 0 ? 1.0 : sin(x) / x);
+            double w = 0.5 + 0.5 * cos(M_PI * t / (METER_TP_TAPS / 2));
+            tp_taps[p][k] = (float) (sinc * w);
+            sum += tp_taps[p][k];
+        }
+        for (int k = 0; k < METER_TP_TAPS; k++) {  // unity gain at DC
+            tp_taps[p][k] /= sum;
+        }
+    }
+
+    // K-weighting (ITU-R BS.1770), stage 1: high shelf
+    double K = tan(M_PI * 1681.974450955533 / AR);
+    double Q = 0.7071752369554196;
+    double Vh = pow(10.0, 3.999843853973347 / 20.0);
+    double Vb = pow(Vh, 0.4996667741545416);
+    double a0 = 1.0 + K / Q + K * K;
+    shelf_b[0] = (float) ((Vh + Vb * K / Q + K * K) / a0);
+    shelf_b[1] = (float) (2.0 * (K * K - Vh) / a0);
+    shelf_b[2] = (float) ((Vh - Vb * K / Q + K * K) / a0);
+    shelf_a[0] = 1.0f;
+    shelf_a[1] = (float) (2.0 * (K * K - 1.0) / a0);
+    shelf_a[2] = (float) ((1.0 - K / Q + K * K) / a0);
+
+    // stage 2: high pass
+    K = tan(M_PI * 38.13547087602444 / AR);
+    Q = 0.5003270373238773;
+    a0 = 1.0 + K / Q + K * K;
+    hp_b[0] = 1.0f;
+    hp_b[1] = -2.0f;
+    hp_b[2] = 1.0f;
+    hp_a[0] = 1.0f;
+    hp_a[1] = (float) (2.0 * (K * K - 1.0) / a0);
+    hp_a[2] = (float) ((1.0 - K / Q + K * K) / a0);
+}
+
+
+void Meter::real_run()
+{
+    if (!running) {
+        return;
+    }
+    input_samps = input->run(current_block);
+
+    const int H = METER_TP_TAPS - 1;  // history length
+    Sample x[H + BL];  // history followed by the input block
+    Sample y[BL];
+    for (int chan = 0; chan < chans; chan++) {
+        Sample *hist = &tp_hist[chan * H];
+        memcpy(x, hist, H * sizeof(Sample));
+        memcpy(x + H, input_samps, BL * sizeof(Sample));
+        memcpy(hist, x + BL, H * sizeof(Sample));
+        Sample *in = x + H;
+
+        // peak and sum of squares, METER_LANES at a time:
+        float pk[METER_LANES] = { 0 };
+        float ss[METER_LANES] = { 0 };
+        for (int i = 0; i < BL; i += METER_LANES) {
+            for (int j = 0; j < METER_LANES; j++) {
+                float s = in[i + j];
+                float a = fabsf(s);
+                pk[j] = std::isgreater(a, pk[j]) ? a : pk[j];
+                ss[j] += s * s;
+            }
+        }
+
+        // true peak: each phase of the interpolator over the whole
+        // block, then its peak. Sample peaks count too.
+        float tp[METER_LANES];
+        memcpy(tp, pk, sizeof(tp));
+        for (int p = 0; p < METER_TP_PHASES; p++) {
+            const float *h = tp_taps[p];
+            for (int i = 0; i < BL; i++) {
+                y[i] = h[0] * in[i];
+            }
+            for (int k = 1; k < METER_TP_TAPS; k++) {
+                float hk = h[k];
+                const Sample *xk = in - k;
+                for (int i = 0; i < BL; i++) {
+                    y[i] += hk * xk[i];
+                }
+            }
+            for (int i = 0; i < BL; i += METER_LANES) {
+                for (int j = 0; j < METER_LANES; j++) {
+                    float a = fabsf(y[i + j]);
+                    tp[j] = std::isgreater(a, tp[j]) ? a : tp[j];
+                }
+            }
+        }
+
+        float peak = peaks[chan];
+        float true_peak = true_peaks[chan];
+        float sumsq = 0;
+        for (int j = 0; j < METER_LANES; j++) {
+            peak = MAX(peak, pk[j]);
+            true_peak = MAX(true_peak, tp[j]);
+            sumsq += ss[j];
+        }
+        peaks[chan] = peak;
+        true_peaks[chan] = true_peak;
+        sumsqs[chan] += sumsq;
+
+        // K-weighting (transposed direct form II), then sum of squares:
+        Sample *st = &kstate[chan * 4];
+        float s1 = st[0], s2 = st[1], s3 = st[2], s4 = st[3];
+        float ksq = 0;
+        for (int i = 0; i < BL; i++) {
+            float u = shelf_b[0] * in[i] + s1;
+            s1 = shelf_b[1] * in[i] - shelf_a[1] * u + s2;
+            s2 = shelf_b[2] * in[i] - shelf_a[2] * u;
+            float v = hp_b[0] * u + s3;
+            s3 = hp_b[1] * u - hp_a[1] * v + s4;
+            s4 = hp_b[2] * u - hp_a[2] * v;
+            ksq += v * v;
+        }
+        st[0] = s1; st[1] = s2; st[2] = s3; st[3] = s4;
+        // replace the oldest block in the loudness window:
+        double &old = kblocks[kblock * chans + chan];
+        ksums[chan] += ksq - old;  // subtract exactly what was added
+        old = ksq;
+
+        input_samps += input_stride;
+    }
+    kblock = (kblock + 1) % window_blocks;
+    if (kblock == 0) {  // resum so that rounding errors cannot accumulate
+        for (int chan = 0; chan < chans; chan++) {
+            double sum = 0;
+            for (int b = 0; b < window_blocks; b++) {
+                sum += kblocks[b * chans + chan];
+            }
+            ksums[chan] = sum;
+        }
+    }
+
+    if (++block_count >= period_blocks) {  // once every period
+        send_meters();
+        peaks.zero();
+        true_peaks.zero();
+        sumsqs.zero();
+        block_count = 0;
+    }
+}
+
+
+// send id, then peak, rms, true peak and loudness for each channel
+void Meter::send_meters()
+{
+    double rms_scale = 1.0 / (block_count * BL);
+    double ms_scale = 1.0 / (window_blocks * BL);
+    o2sm_send_start();
+    o2sm_add_int32(id);
+    for (int chan = 0; chan < chans; chan++) {
+        o2sm_add_float(peaks[chan]);
+        o2sm_add_float((float) sqrt(sumsqs[chan] * rms_scale));
+        o2sm_add_float(true_peaks[chan]);
+        // rounding can leave the running sum slightly below zero:
+        double ms = ksums[chan] * ms_scale;
+        o2sm_add_float(ms > 1e-12 ?  // -120 LUFS
+                       (float) (-0.691 + 10.0 * log10(ms)) : METER_FLOOR);
+    }
+    o2sm_send_finish(0.0, reply_addr, true);
+}
+
+
+void Meter::start(char *reply_addr_, float period)
+{
+    period_blocks = MAX((int) (period * BR + 0.5), 1);
+    int len = (int) strlen(reply_addr_);
+    if (reply_addr) {
+        O2_FREE(reply_addr);
+    }
+    reply_addr = O2_MALLOCNT(len + 1, char);
+    memcpy(reply_addr, reply_addr_, len + 1);
+    running = (input != NULL);
+}
+
+
+/* O2SM INTERFACE: /arco/meter/start int32 id, string reply_addr,
+       float period;
+ */
+static void arco_meter_start(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    char *reply_addr = argv[1]->s;
+    float period = argv[2]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Meter, meter, id, "arco_meter_start");
+    meter->start(reply_addr, period);
+}
+
+
+/* O2SM INTERFACE: /arco/meter/repl_input int32 id, int32 input_id;
+ */
+static void arco_meter_repl_input(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t input_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Meter, meter, id, "arco_meter_repl_input");
+    ANY_UGEN_FROM_ID(input, input_id, "arco_meter_repl_input");
+    meter->repl_input(input);
+}
+
+
+/* O2SM INTERFACE: /arco/meter/new int32 id, int32 chans,
+       string reply_addr, float period;
+ */
+static void arco_meter_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chans = argv[1]->i;
+    char *reply_addr = argv[2]->s;
+    float period = argv[3]->f;
+    // end unpack message
+
+    new Meter(id, chans, reply_addr, period);
+}
+
+
+static void meter_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/meter/start", "isf", arco_meter_start, NULL,
+                    true, true);
+    o2sm_method_new("/arco/meter/repl_input", "ii", arco_meter_repl_input,
+                    NULL, true, true);
+    o2sm_method_new("/arco/meter/new", "iisf", arco_meter_new, NULL,
+                    true, true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer meter_init_obj(meter_init);
@@ -0,0 +1,138 @@
+/* meter.h -- multichannel peak, RMS, true-peak and loudness meter
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Meter measures every channel of its input and sends one message per
+ * period with four floats per channel: peak, RMS, true peak (all
+ * linear amplitude) and momentary loudness (LUFS). One Meter on a
+ * many-channel input (e.g. a mixer's channels and buses) replaces
+ * many Vu's and their messages. The message is
+ *     reply_addr "i" + "ffff" * chans: id, then for each channel
+ *     peak, rms, true_peak, loudness
+ * so that one address can receive from several meters.
+ *
+ * Peak and RMS are over the period. True peak is the peak of the
+ * signal upsampled by 4 with a 48-tap windowed-sinc interpolator (12
+ * taps per phase), as in ITU-R BS.1770 Annex 2. Momentary loudness is
+ * -0.691 + 10 log10(mean square) of the K-weighted signal (a high
+ * shelf and a high-pass biquad, BS.1770) over the last 400 ms, per
+ * channel, with a floor of -120 LUFS.
+ *
+ * Peak, RMS and true-peak loops keep METER_LANES partial results so
+ * that they vectorize without reordering floating point sums. The
+ * K-weighting filters are recursive and run per sample.
+ */
+
+#ifndef __Meter_H__
+#define __Meter_H__
+
+#define METER_LANES 8        // partial sums/maxima per loop
+#define METER_TP_PHASES 4    // true-peak oversampling factor
+#define METER_TP_TAPS 12     // true-peak interpolator taps per phase
+#define METER_WINDOW 0.4     // momentary loudness window in seconds
+#define METER_FLOOR -120.0f  // loudness of silence
+
+extern const char *Meter_name;
+
+class Meter : public Ugen {
+public:
+    char *reply_addr;
+    bool running;
+    int period_blocks;       // blocks per message
+    int block_count;         // blocks since the last message
+    Vec<Sample> peaks;       // per channel, this period
+    Vec<Sample> true_peaks;
+    Vec<double> sumsqs;
+    Vec<Sample> tp_hist;     // last METER_TP_TAPS - 1 inputs per channel
+    Vec<Sample> kstate;      // 4 K-weighting filter states per channel
+    Vec<double> kblocks;     // K-weighted sum of squares per block,
+                             //     [block * chans + chan], a ring
+    Vec<double> ksums;       // sum of kblocks over the window, updated
+                             //     each block and recomputed each window
+    int window_blocks;
+    int kblock;              // where to put the next block in kblocks
+    float tp_taps[METER_TP_PHASES][METER_TP_TAPS];
+    float shelf_b[3], shelf_a[3];  // K-weighting coefficients, a[0] = 1
+    float hp_b[3], hp_a[3];
+
+    Ugen_ptr input;
+    int input_stride;
+    Sample_ptr input_samps;
+
+    // setting output type to 0 because there is no output. chans is
+    // set from the input.
+    Meter(int id, int chans, char *reply_addr_, float period) :
+            Ugen(id, 0, 0) {
+        reply_addr = NULL;
+        input = NULL;
+        running = false;
+        window_blocks = MAX((int) (METER_WINDOW * BR + 0.5), 1);
+        init_filters();
+        start(reply_addr_, period);
+    }
+
+    ~Meter() {
+        if (input) {
+            input->unref(&input);
+        }
+        if (reply_addr) {
+            O2_FREE(reply_addr);
+        }
+    }
+
+    const char *classname() { return Meter_name; }
+
+#if ARCO_REF_DEBUG
+    // for tracing tree of Ugens. Returns true with the ith child in *child
+    // or false if i is too high.
+    bool get_ref(int i, Ugen **child) {
+        // 1 input, may be NULL before repl_input()
+        if (i == 0) { *child = input; return true; }
+        return false;
+    }
+#endif
+
+    void print_details(int indent) {
+        arco_print("running %s period %d blocks",
+                   (running ? "true" : "false"), period_blocks);
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        if (input) {
+            input->print_tree(indent, print_flag, "input");
+        }
+    }
+
+    void repl_input(Ugen_ptr ugen) {
+        if (input) {
+            input->unref(&input);
+        }
+        assert(ugen->rate == 'a');
+        init_param(ugen, input, &input_stride);
+        if (chans != ugen->chans || peaks.size() == 0) {
+            chans = ugen->chans;
+            peaks.set_size(chans);  // initialize, set size, zero fill
+            true_peaks.set_size(chans);
+            sumsqs.set_size(chans);
+            tp_hist.set_size(chans * (METER_TP_TAPS - 1));
+            kstate.set_size(chans * 4);
+            kblocks.set_size(chans * window_blocks);
+            ksums.set_size(chans);
+            kblock = 0;
+            block_count = 0;
+        }
+        running = (reply_addr != NULL && ugen->classname() != Zero_name);
+    }
+
+    void start(char *reply_addr_, float period);
+
+    void init_filters();
+
+    void send_meters();
+
+    void real_run();
+};
+
+#endif
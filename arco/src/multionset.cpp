@@ -0,0 +1,258 @@
+/* multionset.cpp -- batched multichannel onset detection
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include <cmath>
+#include "arcougen.h"
+#include "ffts_compat.h"
+#include "multionset.h"
+
+const char *Multionset_name = "Multionset";
+
+Vec<RTOnsetDetection *> Multionset::old_detectors;
+
+
+Multionset::Multionset(int id, Ugen_ptr input, const char *address_,
+                       int frame_size_, int hop_size_) : Ugen(id, 0, 0)
+{
+    address = o2_heapify(address_);
+    log_frame_size = ilog2(MIN(MAX(frame_size_, 64), 8192));
+    frame_size = 1 << log_frame_size;
+    hop_size = (MIN(MAX(hop_size_, BL), frame_size) / BL) * BL;
+    num_bins = frame_size / 2 + 1;
+    fftInit(log_frame_size);
+    window.set_size(frame_size);
+    for (int i = 0; i < frame_size; i++) {  // as in hann_window()
+        window[i] = 0.5 * (1.0 - cos(2.0 * M_PI * i / (frame_size - 1)));
+    }
+    input_chans = 0;
+    feature_frames = 0;
+    init_input(input);
+}
+
+
+Multionset::~Multionset()
+{
+    input->unref(&input);
+    O2_FREE((char *) address);
+    set_chans(0);  // returns detectors to old_detectors
+}
+
+
+// allocate per-channel state for n channels
+void Multionset::set_chans(int n)
+{
+    if (n == input_chans) {
+        return;
+    }
+    // do not delete detectors, which uses a lock on the heap; instead
+    // push to a free list for possible reuse
+    while (detectors.size() > 0) {
+        old_detectors.push_back(detectors.pop_back());
+    }
+    input_chans = n;
+    samps_stored = 0;
+    if (n == 0) {
+        return;
+    }
+    frames.set_size(n * frame_size);
+    data.set_size(n * frame_size);
+    amps.set_size(num_bins * n);
+    prev_amps.set_size(num_bins * MULTIONSET_ORDER * n);
+    work.set_size((4 * MULTIONSET_ORDER + 4) * n);
+    odf.set_size(n);
+    onsets.set_size(n);
+    for (int i = 0; i < n; i++) {
+        // reuse already allocated objects if possible:
+        detectors.push_back(old_detectors.size() > 0 ?
+                            old_detectors.pop_back() : new RTOnsetDetection());
+    }
+}
+
+
+// Compute odf for every channel from frames. This is
+// LPSpectralDifferenceODF::process_frame() for all channels at once:
+// for each bin, predict the magnitude from the previous
+// MULTIONSET_ORDER magnitudes (Burg's method) and sum the absolute
+// prediction errors. burg() with signal_size == num_coefs == order
+// reduces to the loops below; its last iteration has no terms and
+// does not change the coefficients, so it is omitted.
+void Multionset::detect_function()
+{
+    const int P = MULTIONSET_ORDER;
+    const int C = input_chans;
+    for (int chan = 0; chan < C; chan++) {
+        Sample *frame = &frames[chan * frame_size];
+        Sample *d = &data[chan * frame_size];
+        for (int i = 0; i < frame_size; i++) {
+            d[i] = frame[i] * window[i];
+        }
+    }
+    rffts(&data[0], log_frame_size, C);  // all channels
+
+    // magnitudes, transposed to [bin][chan]. Row 0 of each spectrum
+    // holds DC and Nyquist:
+    for (int chan = 0; chan < C; chan++) {
+        Sample *d = &data[chan * frame_size];
+        amps[chan] = fabsf(d[0]);
+        amps[(num_bins - 1) * C + chan] = fabsf(d[1]);
+        for (int bin = 1; bin < num_bins - 1; bin++) {
+            float re = d[bin * 2];
+            float im = d[bin * 2 + 1];
+            amps[bin * C + chan] = sqrtf(re * re + im * im);
+        }
+    }
+
+    Sample *f = &work[0];        // forward errors, [P][C]
+    Sample *b = f + P * C;       // backward errors, [P][C]
+    Sample *a = b + P * C;       // coefficients, a[0] = 1, [P + 1][C]
+    Sample *r = a + (P + 1) * C; // coefficients reversed, [P + 1][C]
+    Sample *sum = r + (P + 1) * C;
+    Sample *fb = sum + C;
+    for (int c = 0; c < C; c++) {
+        odf[c] = 0;
+    }
+    for (int bin = 0; bin < num_bins; bin++) {
+        Sample *x = &prev_amps[bin * P * C];
+        Sample *amp = &amps[bin * C];
+        memcpy(f, x, P * C * sizeof(Sample));
+        memcpy(b, x, P * C * sizeof(Sample));
+        for (int c = 0; c < C; c++) {
+            a[c] = 1;
+        }
+        memset(a + C, 0, P * C * sizeof(Sample));
+        for (int k = 0; k < P - 1; k++) {
+            int fl = k + 1;
+            for (int c = 0; c < C; c++) {
+                sum[c] = 0;
+                fb[c] = 0;
+            }
+            for (int n = fl; n < P; n++) {
+                Sample *fn = f + n * C;
+                Sample *bn = b + (n - fl) * C;
+                for (int c = 0; c < C; c++) {
+                    sum[c] += fn[c] * fn[c] + bn[c] * bn[c];
+                    fb[c] += fn[c] * bn[c];
+                }
+            }
+            Sample *mu = sum;  // reuse sum for mu
+            for (int c = 0; c < C; c++) {
+                bool pos = std::isgreater(sum[c], 0.0f);
+                float denom = pos ? sum[c] : 1.0f;
+                mu[c] = pos ? -2.0f * fb[c] / denom : 0.0f;
+            }
+            for (int n = 0; n <= fl; n++) {
+                memcpy(r + n * C, a + (fl - n) * C, C * sizeof(Sample));
+            }
+            for (int n = 0; n <= fl; n++) {
+                Sample *an = a + n * C;
+                Sample *rn = r + n * C;
+                for (int c = 0; c < C; c++) {
+                    an[c] += mu[c] * rn[c];
+                }
+            }
+            for (int n = fl; n < P; n++) {
+                Sample *fn = f + n * C;
+                Sample *bn = b + (n - fl) * C;
+                for (int c = 0; c < C; c++) {
+                    float temp = fn[c];
+                    fn[c] += mu[c] * bn[c];
+                    bn[c] += mu[c] * temp;
+                }
+            }
+        }
+        // prediction is -sum(a[j + 1] * x[P - 1 - j]); accumulate error:
+        for (int c = 0; c < C; c++) {
+            float prediction = 0;
+            for (int j = 0; j < P; j++) {
+                prediction -= a[(j + 1) * C + c] * x[(P - 1 - j) * C + c];
+            }
+            odf[c] += fabsf(amp[c] - prediction);
+        }
+        // move magnitudes back by 1
+        memmove(x, x + C, (P - 1) * C * sizeof(Sample));
+        memcpy(x + (P - 1) * C, amp, C * sizeof(Sample));
+    }
+}
+
+
+void Multionset::real_run()
+{
+    input_samps = input->run(current_block);
+
+    for (int i = 0; i < input_chans; i++) {
+        // copy one input block (a channel) to each frame buffer
+        block_copy(&frames[i * frame_size] + samps_stored,
+                   input_samps + i * input_stride);
+    }
+    samps_stored += BL;
+    if (samps_stored < frame_size) return;
+
+    detect_function();
+    for (int i = 0; i < input_chans; i++) {
+        bool onset = detectors[i]->is_onset(odf[i]);
+        onsets[i] = (onset ? 1.0f : 0.0f);
+        if (onset && address[0]) {
+            o2sm_send_start();
+            o2sm_add_int32(id);
+            o2sm_add_int32(i); // send which channel
+            o2sm_send_finish(0, address, false);
+        }
+    }
+    feature_frames++;
+
+    // shift by hop_size
+    samps_stored = frame_size - hop_size;
+    for (int i = 0; i < input_chans; i++) {
+        Sample *frame = &frames[i * frame_size];
+        memmove(frame, frame + hop_size, samps_stored * sizeof(Sample));
+    }
+}
+
+
+/* O2SM INTERFACE: /arco/multionset/new int32 id, int32 input_id,
+       string reply_addr, int32 frame_size, int32 hop_size;
+ */
+static void arco_multionset_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t input_id = argv[1]->i;
+    char *reply_addr = argv[2]->s;
+    int32_t frame_size = argv[3]->i;
+    int32_t hop_size = argv[4]->i;
+    // end unpack message
+
+    ANY_UGEN_FROM_ID(input, input_id, "arco_multionset_new");
+    new Multionset(id, input, reply_addr, frame_size, hop_size);
+}
+
+
+/* O2SM INTERFACE: /arco/multionset/repl_input int32 id, int32 input_id;
+ */
+static void arco_multionset_repl_input(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t input_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Multionset, multionset, id, "arco_multionset_repl_input");
+    ANY_UGEN_FROM_ID(input, input_id, "arco_multionset_repl_input");
+    multionset->repl_input(input);
+}
+
+
+static void multionset_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/multionset/new", "iisii", arco_multionset_new,
+                    NULL, true, true);
+    o2sm_method_new("/arco/multionset/repl_input", "ii",
+                    arco_multionset_repl_input, NULL, true, true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer multionset_init_obj(multionset_init);
@@ -0,0 +1,113 @@
+/* multionset.h -- batched multichannel onset detection
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Multionset detects onsets in every channel of its input, like Onset,
+ * and sends the same messages (id, channel) to address. Instead of an
+ * LPSpectralDifferenceODF per channel, it computes the linear
+ * prediction spectral difference onset detection function for all
+ * channels together: each hop, the windowed frames of all channels are
+ * transformed with one rffts() call, and the per-bin Burg linear
+ * prediction runs with channels as the inner loop, so that it
+ * vectorizes. Peak picking uses an RTOnsetDetection per channel.
+ *
+ * frame_size is a power of 2 from 64 to 8192, and hop_size is a
+ * multiple of BL no larger than frame_size (they are rounded to fit).
+ * Onset uses 256 and 128.
+ *
+ * An empty address stops messages; results are still available to
+ * Featurevec (1 for a channel with an onset in the last frame, else 0).
+ */
+
+#ifndef __Multionset_H__
+#define __Multionset_H__
+
+#include "onsetdetection.h"
+
+#define MULTIONSET_ORDER 5  // linear prediction order, as in the ODF
+
+extern const char *Multionset_name;
+
+class Multionset : public Ugen {
+  public:
+    const char *address; // where to send messages
+
+    Ugen_ptr input;
+    int input_stride;
+    Sample_ptr input_samps;
+
+    int frame_size;
+    int log_frame_size;
+    int hop_size;
+    int num_bins;
+    int input_chans;
+    int samps_stored;
+
+    Vec<Sample> window;     // Hann window, frame_size
+    Vec<Sample> frames;     // input, [chan][frame_size]
+    Vec<Sample> data;       // windowed frames, then spectra, same layout
+    Vec<Sample> amps;       // magnitudes, [bin][chan]
+    Vec<Sample> prev_amps;  // [bin][MULTIONSET_ORDER][chan], oldest first
+    Vec<Sample> work;       // Burg recursion, see detect_function()
+    Vec<Sample> odf;        // onset detection function, [chan]
+    Vec<Sample> onsets;     // 1 if channel had an onset in the last frame
+    int feature_frames;     // count of frames (see get_features())
+    Vec<RTOnsetDetection *> detectors;
+
+    // for freeing
+    static Vec<RTOnsetDetection *> old_detectors;
+
+    Multionset(int id, Ugen_ptr input, const char *address_,
+               int frame_size_, int hop_size_);
+
+    ~Multionset();
+
+    const char *classname() { return Multionset_name; }
+
+#if ARCO_REF_DEBUG
+    // for tracing tree of Ugens. Returns true with the ith child in *child
+    // or false if i is too high.
+    bool get_ref(int i, Ugen **child) {
+        // 1 input
+        if (i == 0) { *child = input; return true; }
+        return false;
+    }
+#endif
+
+    void print_details(int indent) {
+        arco_print("frame_size %d hop_size %d chans %d", frame_size,
+                   hop_size, input_chans);
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        input->print_tree(indent, print_flag, "input");
+    }
+
+    void init_input(Ugen_ptr ugen) {
+        assert(ugen->rate == 'a');
+        init_param(ugen, input, &input_stride);
+        set_chans(ugen->chans);
+    }
+
+    void repl_input(Ugen_ptr ugen) {
+        input->unref(&input);
+        init_input(ugen);
+    }
+
+    void set_chans(int n);
+
+    void detect_function();
+
+    void real_run();
+
+    // features are 1 (onset) or 0 for each channel
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = &onsets[0];
+        *frame_count = feature_frames;
+        return input_chans;
+    }
+};
+
+#endif
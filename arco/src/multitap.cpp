@@ -0,0 +1,202 @@
+/* multitap.cpp -- multi-tap fractional delay
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "multitap.h"
+
+const char *Multitap_name = "Multitap";
+
+
+void Multitap::real_run()
+{
+    input_samps = input->run(current_block);  // update inputs
+    for (int t = 0; t < taps.size(); t++) {
+        taps[t].dur_samps = taps[t].dur->run(current_block);
+    }
+    block_zero_n(out_samps, chans);
+
+    float d[BL];       // delay in samples
+    float frac[BL];    // weight of the older sample
+    int32_t ix[BL];    // index of the older sample
+    Sample older[BL];
+    Sample newer[BL];
+    for (int chan = 0; chan < chans; chan++) {
+        Sample *line = &buf[2 * len * chan];
+        Sample *out = out_samps + chan * BL;
+        // write the input block in both halves of the mirrored buffer:
+        memcpy(line + write, input_samps, BL * sizeof(Sample));
+        memcpy(line + write + len, input_samps, BL * sizeof(Sample));
+
+        for (int t = 0; t < taps.size(); t++) {
+            Tap &tap = taps[t];
+            Sample_ptr dur = tap.dur_samps + chan * tap.dur_stride;
+            if (tap.dur->rate == 'a') {
+                for (int i = 0; i < BL; i++) {
+                    d[i] = dur[i] * AR;
+                }
+            } else {  // interpolate from the previous block
+                Sample &prev = dur_prev[t * chans + chan];
+                float d0 = prev * AR;
+                float d_incr = (*dur - prev) * AR * BL_RECIP;
+                prev = *dur;
+                for (int i = 0; i < BL; i++) {
+                    d[i] = d0 + d_incr * (i + 1);
+                }
+            }
+            // The output at block offset i is at position write + i - d,
+            // between the samples at write + i - (int) d - 1 and the next
+            // one. std::isless/isgreater (rather than fminf/fmaxf or <, >)
+            // let this loop vectorize:
+            for (int i = 0; i < BL; i++) {
+                float di = d[i];
+                di = std::isless(di, 0.0f) ? 0.0f : di;
+                di = std::isgreater(di, max_samps) ? max_samps : di;
+                int32_t whole = (int32_t) di;
+                frac[i] = di - (float) whole;
+                ix[i] = (write + i - whole - 1) & mask;
+            }
+            // gather (scalar), then interpolate and mix (vectorized):
+            for (int i = 0; i < BL; i++) {
+                older[i] = line[ix[i]];
+                newer[i] = line[ix[i] + 1];  // mirrored, so no wrap
+            }
+            // every channel ramps from gain_prev to gain:
+            float g = tap.gain_prev;
+            float g_incr = (tap.gain - g) * BL_RECIP;
+            for (int i = 0; i < BL; i++) {
+                out[i] += (g + g_incr * (i + 1)) *
+                          (newer[i] + frac[i] * (older[i] - newer[i]));
+            }
+        }
+        input_samps += input_stride;
+    }
+    for (int t = 0; t < taps.size(); t++) {
+        taps[t].gain_prev = taps[t].gain;
+    }
+    write = (write + BL) & mask;
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/new int32 id, int32 chans, int32 input,
+       float maxdur, int32 ntaps;
+ */
+void arco_multitap_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chans = argv[1]->i;
+    int32_t input = argv[2]->i;
+    float maxdur = argv[3]->f;
+    int32_t ntaps = argv[4]->i;
+    // end unpack message
+
+    ANY_UGEN_FROM_ID(input_ugen, input, "arco_multitap_new");
+    new Multitap(id, chans, input_ugen, maxdur, ntaps);
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/repl_input int32 id, int32 input_id;
+ */
+static void arco_multitap_repl_input(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t input_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Multitap, multitap, id, "arco_multitap_repl_input");
+    ANY_UGEN_FROM_ID(input, input_id, "arco_multitap_repl_input");
+    multitap->repl_input(input);
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/tap int32 id, int32 tap, int32 dur_id,
+       float gain;
+ */
+static void arco_multitap_tap(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t tap = argv[1]->i;
+    int32_t dur_id = argv[2]->i;
+    float gain = argv[3]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Multitap, multitap, id, "arco_multitap_tap");
+    ANY_UGEN_FROM_ID(dur, dur_id, "arco_multitap_tap");
+    multitap->repl_dur(tap, dur);
+    multitap->set_gain(tap, gain);
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/repl_dur int32 id, int32 tap,
+       int32 dur_id;
+ */
+static void arco_multitap_repl_dur(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t tap = argv[1]->i;
+    int32_t dur_id = argv[2]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Multitap, multitap, id, "arco_multitap_repl_dur");
+    ANY_UGEN_FROM_ID(dur, dur_id, "arco_multitap_repl_dur");
+    multitap->repl_dur(tap, dur);
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/set_dur int32 id, int32 tap, int32 chan,
+       float dur;
+ */
+static void arco_multitap_set_dur(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t tap = argv[1]->i;
+    int32_t chan = argv[2]->i;
+    float dur = argv[3]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Multitap, multitap, id, "arco_multitap_set_dur");
+    multitap->set_dur(tap, chan, dur);
+}
+
+
+/* O2SM INTERFACE: /arco/multitap/gain int32 id, int32 tap, float gain;
+ */
+static void arco_multitap_gain(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t tap = argv[1]->i;
+    float gain = argv[2]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Multitap, multitap, id, "arco_multitap_gain");
+    multitap->set_gain(tap, gain);
+}
+
+
+static void multitap_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/multitap/new", "iiifi", arco_multitap_new, NULL,
+                    true, true);
+    o2sm_method_new("/arco/multitap/repl_input", "ii",
+                    arco_multitap_repl_input, NULL, true, true);
+    o2sm_method_new("/arco/multitap/tap", "iiif", arco_multitap_tap, NULL,
+                    true, true);
+    o2sm_method_new("/arco/multitap/repl_dur", "iii", arco_multitap_repl_dur,
+                    NULL, true, true);
+    o2sm_method_new("/arco/multitap/set_dur", "iiif", arco_multitap_set_dur,
+                    NULL, true, true);
+    o2sm_method_new("/arco/multitap/gain", "iif", arco_multitap_gain, NULL,
+                    true, true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer multitap_init_obj(multitap_init);
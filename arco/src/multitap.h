@@ -0,0 +1,136 @@
+/* multitap.h -- multi-tap fractional delay
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Multitap reads ntaps modulated, fractional delays from one delay
+ * line per channel and outputs the sum of the taps, each scaled by a
+ * gain. This does the work of several Delayvi's over the same input
+ * (as in chorus, flanger and ensemble effects) with one buffer write
+ * per sample rather than one per tap.
+ *
+ * Taps are numbered from 0. Each tap has a delay input (dur, in
+ * seconds, audio rate or block rate, 1 or chans channels) and a float
+ * gain. Initially, every tap has dur = zero_ugen and gain = 0. Block
+ * rate durations are linearly interpolated across the block, and gain
+ * changes ramp over one block.
+ *
+ * The delay line is "mirrored": a buffer of 2 * len samples holds
+ * every sample at index k and k + len, where len is a power of 2. The
+ * interpolation reads samples at k and k + 1 without wrapping, so
+ * each tap is computed in simple loops over the block: one computes
+ * indices and fractions, one gathers the two samples for each output
+ * sample, and one interpolates and mixes. All but the gather
+ * vectorize. The whole input block is written before taps are read,
+ * so delays shorter than a block are fine. Delays are limited to
+ * 0 <= dur <= maxdur.
+ */
+
+extern const char *Multitap_name;
+
+class Multitap : public Ugen {
+public:
+    struct Tap {
+        Ugen_ptr dur;
+        int dur_stride;
+        Sample_ptr dur_samps;
+        float gain;
+        float gain_prev;
+    };
+    Vec<Tap> taps;
+    Vec<Sample> dur_prev;  // previous block-rate dur, [tap * chans + chan]
+    Vec<Sample> buf;       // all channels, 2 * len samples each
+    int len;               // power of 2 >= maxdur * AR + BL + 1
+    int mask;
+    int write;             // where to write the next input block
+    float max_samps;       // maxdur in samples
+
+    Ugen_ptr input;
+    int input_stride;
+    Sample_ptr input_samps;
+
+    Multitap(int id, int nchans, Ugen_ptr input_, float maxdur,
+             int ntaps) : Ugen(id, 'a', nchans) {
+        int n = (int) ceilf(MAX(maxdur, 0) * AR) + BL + 1;
+        len = BL;
+        while (len < n) len <<= 1;
+        mask = len - 1;
+        write = 0;
+        max_samps = MIN((float) (len - BL - 1), MAX(maxdur, 0) * AR);
+        buf.set_size(2 * len * chans);  // zero fill
+
+        taps.set_size(MAX(ntaps, 0));
+        for (int t = 0; t < taps.size(); t++) {
+            Tap &tap = taps[t];
+            tap.dur = ugen_table[ZERO_ID];
+            tap.dur->ref();
+            tap.dur_stride = 0;
+            tap.gain = 0;
+            tap.gain_prev = 0;
+        }
+        dur_prev.set_size(taps.size() * chans);
+        init_input(input_);
+    }
+
+    ~Multitap() {
+        input->unref(&input);
+        for (int t = 0; t < taps.size(); t++) {
+            taps[t].dur->unref(&taps[t].dur);
+        }
+        taps.finish();
+        dur_prev.finish();
+        buf.finish();
+    }
+
+    const char *classname() { return Multitap_name; }
+
+    void print_details(int indent) {
+        arco_print("taps %d maxdur %g", taps.size(), max_samps * AP);
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        input->print_tree(indent, print_flag, "input");
+        for (int t = 0; t < taps.size(); t++) {
+            taps[t].dur->print_tree(indent, print_flag, "dur");
+        }
+    }
+
+    void repl_input(Ugen_ptr ugen) {
+        input->unref(&input);
+        init_input(ugen);
+    }
+
+    void init_input(Ugen_ptr ugen) {
+        if (ugen->rate == 'b') {
+            ugen = new Upsample(-1, ugen->chans, ugen);
+        }
+        init_param(ugen, input, &input_stride);
+    }
+
+    bool tap_ok(int t, const char *from) {
+        if (t < 0 || t >= taps.size()) {
+            arco_warn("%s: tap %d does not exist", from, t);
+            return false;
+        }
+        return true;
+    }
+
+    void repl_dur(int t, Ugen_ptr ugen) {
+        if (!tap_ok(t, "Multitap::repl_dur")) return;
+        taps[t].dur->unref(&taps[t].dur);
+        init_param(ugen, taps[t].dur, &taps[t].dur_stride);
+    }
+
+    void set_dur(int t, int chan, float f) {
+        if (!tap_ok(t, "Multitap::set_dur")) return;
+        taps[t].dur->const_set(chan, f, "Multitap::set_dur");
+    }
+
+    void set_gain(int t, float g) {
+        if (!tap_ok(t, "Multitap::set_gain")) return;
+        taps[t].gain = g;
+    }
+
+    void real_run();
+};
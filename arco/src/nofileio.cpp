@@ -14,6 +14,8 @@
 #include "nofileio.h"
 
 bool fileio_finished = false;
+
+void *fileio_bridge = NULL;  // no bridge, so Recplay cannot spill
     
 // to be called from main thread.
 //
@@ -6,3 +6,4 @@
 
 extern bool fileio_finished;  // used by audio thread to know when fileio is shutdown
 int fileio_initialize();
+extern void *fileio_bridge;  // always NULL
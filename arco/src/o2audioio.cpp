@@ -9,11 +9,538 @@
 #include "sharedmem.h"
 #include "const.h"
 #include "blockqueue.h"
+#include "bufferpool.h"
 #include "audioblob.h"
+#include "offload.h"
 #include "o2audioio.h"
 
 const char *O2audioio_name = "O2audioio";
 
+
+// Coding jobs are reused so that the audio thread does not allocate
+// and free a job and its buffers for every message: release() puts a
+// finished job on a free list, and get() takes one from it. A job
+// keeps its buffers, which only grow. Each coded O2audioio reserves
+// O2AUD_JOB_RESERVE jobs of each kind it uses, created and sized for
+// its stream when it is constructed, and jobs beyond the total
+// reserve are deleted when released.
+
+class O2aud_job_pool {
+  public:
+    O2queue jobs;  // free jobs, linked through their Offload_link
+    int available;  // how many in jobs (audio thread only)
+    int reserved;   // how many to keep
+
+    O2aud_job_pool() { available = 0; reserved = 0; }
+
+    Offload_job *get() {
+        Offload_link *link = (Offload_link *) jobs.pop();
+        if (!link) {
+            return NULL;
+        }
+        available--;
+        return link->job;
+    }
+
+    void put(Offload_job *job) {
+        if (available >= reserved) {
+            delete job;  // only after O2audioio's are deleted
+            return;
+        }
+        jobs.push((O2list_elem *) &job->link);
+        available++;
+    }
+
+    // delete free jobs beyond the reserve
+    void trim() {
+        while (available > reserved) {
+            delete get();
+        }
+    }
+};
+
+static O2aud_job_pool o2aud_encode_pool;
+static O2aud_job_pool o2aud_decode_pool;
+
+
+// code an outgoing blob on the main thread, then send it from the
+// audio thread (see "Coded samples" in o2audioio.h)
+class O2aud_encode_job : public Offload_job {
+  public:
+    O2audioio *owner;
+    double when;
+    int64_t framecount;
+    int frames;
+    int chans;
+    int16_t *samps;     // copy of the raw samples
+    int samps_len;      // allocated length of samps
+    O2blob_ptr coded;   // the coded blob built by run()
+    int coded_len;      // allocated length of coded->data
+
+    O2aud_encode_job() {
+        samps = NULL;
+        samps_len = 0;
+        coded = NULL;
+        coded_len = 0;
+    }
+
+    ~O2aud_encode_job() {
+        if (samps) O2_FREE(samps);
+        if (coded) O2_FREE(coded);
+    }
+
+    // make room to copy frames * chans samples
+    void reserve(int frames_, int chans_) {
+        frames = frames_;
+        chans = chans_;
+        if (samps_len < frames * chans) {
+            if (samps) O2_FREE(samps);
+            samps_len = frames * chans;
+            samps = O2_MALLOCNT(samps_len, int16_t);
+        }
+    }
+
+    // get a job to code owner's out_blob
+    static O2aud_encode_job *get(O2audioio *owner, double when,
+                                 int64_t framecount) {
+        O2aud_encode_job *job = (O2aud_encode_job *) o2aud_encode_pool.get();
+        if (!job) {
+            job = new O2aud_encode_job();
+        }
+        job->owner = owner;
+        owner->ref();  // do not delete owner until finish()
+        job->when = when;
+        job->framecount = framecount;
+        job->reserve(owner->out_blob.frames, owner->out_blob.chans);
+        memcpy(job->samps, owner->out_blob.blob->data,
+               job->frames * job->chans * sizeof(int16_t));
+        return job;
+    }
+
+    void run() {
+        int len = BLOB_CODED_MAX(frames, chans);
+        if (coded_len < len) {  // allocate here on the main thread
+            if (coded) O2_FREE(coded);
+            coded = o2_blob_new(len);
+            coded_len = len;
+        }
+        coded->size = blob_encode(samps, frames, chans,
+                                  (uint8_t *) coded->data);
+    }
+
+    void finish() {
+        owner->send_data(when, framecount, coded);  // copies coded
+        owner->unref((Ugen **) &owner);
+    }
+
+    void release() { o2aud_encode_pool.put(this); }
+};
+
+
+// decode an incoming blob on the main thread, then handle it on the
+// audio thread as if it arrived raw (but in host byte order)
+class O2aud_decode_job : public Offload_job {
+  public:
+    O2audioio *owner;
+    double when;
+    int64_t framecount;
+    int frames;
+    int chans;
+    int len;
+    uint8_t *code;      // copy of the coded blob content
+    int code_len;       // allocated length of code
+    O2blob_ptr samps;   // decoded samples built by run()
+    int samps_len;      // allocated length of samps->data
+    bool ok;
+
+    O2aud_decode_job() {
+        code = NULL;
+        code_len = 0;
+        samps = NULL;
+        samps_len = 0;
+    }
+
+    ~O2aud_decode_job() {
+        if (code) O2_FREE(code);
+        if (samps) O2_FREE(samps);
+    }
+
+    // make room to copy n bytes of code
+    void reserve(int n) {
+        if (code_len < n) {
+            if (code) O2_FREE(code);
+            code_len = MAX(n, 1);
+            code = O2_MALLOCNT(code_len, uint8_t);
+        }
+    }
+
+    // get a job to decode blob for owner
+    static O2aud_decode_job *get(O2audioio *owner, double when,
+                                 int64_t framecount, O2blob_ptr blob) {
+        O2aud_decode_job *job = (O2aud_decode_job *) o2aud_decode_pool.get();
+        if (!job) {
+            job = new O2aud_decode_job();
+        }
+        job->owner = owner;
+        owner->ref();  // do not delete owner until finish()
+        job->when = when;
+        job->framecount = framecount;
+        job->frames = owner->out_blob.frames;
+        job->chans = owner->chans;
+        job->len = blob->size;
+        job->reserve(job->len);
+        memcpy(job->code, blob->data, job->len);
+        job->ok = false;
+        return job;
+    }
+
+    void run() {
+        int n = frames * chans * sizeof(int16_t);
+        if (samps_len < n) {  // allocate here on the main thread
+            if (samps) O2_FREE(samps);
+            samps = o2_blob_new(n);
+            samps_len = n;
+        }
+        samps->size = n;
+        ok = blob_decode(code, len, frames, chans,
+                         (int16_t *) samps->data);
+    }
+
+    void finish() {
+        if (ok) {
+            owner->data(when, framecount, samps);  // copies samps
+        } else {
+            arco_warn("O2audioio %d: invalid coded blob, framecount %lld",
+                      owner->id, (long long) framecount);
+        }
+        owner->unref((Ugen **) &owner);
+    }
+
+    void release() { o2aud_decode_pool.put(this); }
+};
+
+
+// reserve (n > 0) or unreserve (n < 0) coding jobs for this stream
+//
+void O2audioio::reserve_jobs(int n)
+{
+    if (has_input) {
+        o2aud_encode_pool.reserved += n;
+        while (o2aud_encode_pool.available < o2aud_encode_pool.reserved) {
+            O2aud_encode_job *job = new O2aud_encode_job();
+            job->reserve(out_blob.frames, out_blob.chans);
+            o2aud_encode_pool.put(job);
+        }
+        o2aud_encode_pool.trim();
+    }
+    if (has_output) {
+        o2aud_decode_pool.reserved += n;
+        while (o2aud_decode_pool.available < o2aud_decode_pool.reserved) {
+            O2aud_decode_job *job = new O2aud_decode_job();
+            job->reserve(BLOB_CODED_MAX(out_blob.frames, chans));
+            o2aud_decode_pool.put(job);
+        }
+        o2aud_decode_pool.trim();
+    }
+}
+
+
+// hand off a full out_blob to the main thread for coding
+//
+void O2audioio::send_coded(int64_t framecount)
+{
+    offload(O2aud_encode_job::get(this, o2sm_time_get(), framecount));
+    out_blob.clear();
+}
+
+
+// send a /data message with samps, which is already in network order
+// or coded
+//
+void O2audioio::send_data(double when, int64_t framecount,
+                          O2blob_ptr samps)
+{
+    const char *data_addr = complete_address("data");
+    o2sm_send_start();
+    o2sm_add_int32(id);
+    o2sm_add_time(when);
+    o2sm_add_int64(framecount);
+    o2sm_add_blob(samps);
+    o2sm_send_finish(0, data_addr, true);
+}
+
+// every ADAPT_PERIOD, decide whether to grow or shrink the buffer
+// (see "Adaptive buffer size" in o2audioio.h)
+//
+void O2audioio::adapt_check()
+{
+    if (frame_count < adapt_frame) {
+        return;
+    }
+    adapt_frame = frame_count + (int64_t) (ADAPT_PERIOD * AR);
+    int slack = window_slack;
+    window_slack = INT_MAX;
+    if (buffer_frames_max < adapt_min) {
+        adapt_step = 1;
+    } else if (buffer_frames_max > adapt_max) {
+        adapt_step = -1;
+    } else if (slack == INT_MAX) {
+        return;  // no messages this period, nothing to learn
+    } else {
+        int margin = BL + (int) (ADAPT_JITTER * jitter * AR);
+        if (slack < margin && buffer_frames_max < adapt_max) {
+            adapt_step = 1;
+        } else if (slack > margin + 2 * BL && frame_count >= hold_frame &&
+                   buffer_frames_max > adapt_min) {
+            adapt_step = -1;
+        }
+    }
+}
+
+
+// compute output while growing or shrinking the buffer by one block.
+// Returns false if there is nothing to do (or not enough queued data),
+// in which case the caller dequeues a block as usual.
+//
+bool O2audioio::adapt_output()
+{
+    if (buffer.get_fifo_len() < 2) {
+        adapt_step = 0;
+        adapt_xfade = false;
+        return false;
+    }
+    Sample *b = stage_block.get_array();
+    if (adapt_xfade) {  // grow, 2nd block: crossfade from next back to head
+        peek_block(0, out_samps);
+        peek_block(1, b);
+        for (int i = 0; i < BL * chans; i++) {
+            float w = ((i % BL) + 1) * BL_RECIP;  // weight of head block
+            out_samps[i] = b[i] + w * (out_samps[i] - b[i]);
+        }
+        buffer.toss();
+        adapt_xfade = false;
+    } else if (adapt_step > 0) {  // grow, 1st block: output head, keep it
+        peek_block(0, out_samps);
+        buffer_frames_max += BL;
+        next_buffer_frame += BL;
+        adapt_xfade = true;
+    } else if (adapt_step < 0) {  // shrink: crossfade from head to next
+        peek_block(0, out_samps);
+        peek_block(1, b);
+        for (int i = 0; i < BL * chans; i++) {
+            float w = ((i % BL) + 1) * BL_RECIP;  // weight of next block
+            out_samps[i] += w * (b[i] - out_samps[i]);
+        }
+        buffer.toss();
+        buffer.toss();
+        buffer_frames_max -= BL;
+        next_buffer_frame -= BL;
+    } else {
+        return false;
+    }
+    adapt_step = 0;
+    return true;
+}
+
+
+// copy the nth block from the head of buffer to dst as floats
+//
+void O2audioio::peek_block(int n, Sample *dst)
+{
+    char *src = buffer.peek(n);
+    if (floattype) {
+        memcpy(dst, src, buffer.blocksize);
+    } else {
+        int16_t *s16 = (int16_t *) src;
+        for (int i = 0; i < BL * chans; i++) {
+            dst[i] = INT16_TO_FLOAT(s16[i]);
+        }
+    }
+}
+
+
+// send statistics: reply_addr "iiifiB" id latency min_slack jitter
+//     underflows adaptive
+//
+void O2audioio::stats(const char *reply_addr)
+{
+    o2sm_send_start();
+    o2sm_add_int32(id);
+    o2sm_add_int32(buffer_frames_max);
+    o2sm_add_int32(min_buffer_len);
+    o2sm_add_float((float) jitter);
+    o2sm_add_int32(underflows);
+    o2sm_add_bool(adaptive);
+    o2sm_send_finish(0, reply_addr, true);
+}
+
+
+// handle incoming audio when drift compensation is enabled: frames
+// are queued as a continuous stream without aligning framecount to
+// frame_count (see "Clock drift" in o2audioio.h)
+//
+void O2audioio::data_drift(double when, int64_t framecount,
+                           O2blob_ptr samps)
+{
+    int frames = out_blob.frames;
+    assert((int) samps->size == frames * chans * 2 * (floattype + 1));
+    if (!recv_started) {
+        next_recv_frame = framecount;
+        recv_started = true;
+    }
+    if (framecount < next_recv_frame) {
+        return;  // this message is late or a duplicate, throw it out
+    }
+    drift_observe(when, framecount);
+    int space = buffer.size() - buffer.get_fifo_len();  // in blocks
+    int gap = (int) MIN((framecount - next_recv_frame) / BL, space);
+    while (gap-- > 0) {  // some messages were dropped, so zero fill
+        buffer.enqueue_zeros();
+        space--;
+    }
+    next_recv_frame = framecount + frames;
+    if (space < frames / BL) {
+        arco_print("o2audioio: overflow, id %d\n", id);
+        return;  // drop the data; stepping faster will drain the buffer
+    }
+    if (recv_swap) {  // decoded blobs are already in host order
+        blob_swap(samps->data, frames, chans, floattype);
+    }
+    for (int f = 0; f < frames; f += BL) {
+        buffer.enqueue(samps->data + f * chans * 2 * (floattype + 1));
+    }
+
+    if (last_report_frame_count + AR * 3 <= frame_count) {
+        arco_print("O2audioio %d fill %g frms (target %g) drift %g ppm\n",
+                   id, fill_smoothed, fill_target,
+                   (drift_ratio - 1) * 1000000);
+        last_report_frame_count = frame_count;
+    }
+}
+
+
+// add a point to the drift history (at most one per DRIFT_INTERVAL)
+// and update drift_ratio from the oldest and newest points
+//
+void O2audioio::drift_observe(double when, int64_t framecount)
+{
+    double now = o2sm_time_get();
+    if (drift_count > 0) {
+        Drift_point &last = drift_points[(drift_next + DRIFT_POINTS - 1) %
+                                         DRIFT_POINTS];
+        if (now - last.now < DRIFT_INTERVAL) {
+            return;
+        }
+    }
+    Drift_point &point = drift_points[drift_next];
+    point.when = when;
+    point.framecount = framecount;
+    point.now = now;
+    point.frame_count = frame_count;
+    drift_next = (drift_next + 1) % DRIFT_POINTS;
+    drift_count = MIN(drift_count + 1, DRIFT_POINTS);
+    if (drift_count < DRIFT_MIN_POINTS) {
+        return;
+    }
+    Drift_point &first = drift_points[(drift_next + DRIFT_POINTS -
+                                       drift_count) % DRIFT_POINTS];
+    double sender_dt = point.when - first.when;
+    double our_dt = point.now - first.now;
+    if (sender_dt <= 0 || our_dt <= 0 ||
+        point.frame_count <= first.frame_count) {
+        return;  // clock jumped; keep the previous estimate
+    }
+    // sender frames per second / our frames per second:
+    double ratio = ((point.framecount - first.framecount) / sender_dt) /
+                   ((point.frame_count - first.frame_count) / our_dt);
+    drift_ratio = MAX(1 - DRIFT_MAX, MIN(1 + DRIFT_MAX, ratio));
+    if (fill_target < 0) {  // first estimate: hold the current latency
+        fill_target = fill_smoothed;
+    }
+}
+
+
+// compute one block of output by resampling from buffer
+//
+void O2audioio::run_drift()
+{
+    // update the fill level (in sender frames) and choose a step:
+    double fill = buffer.get_fifo_len() * BL + stage_frames - rs_pos;
+    fill_smoothed += (fill - fill_smoothed) * (BL * AP);  // ~1s time const.
+    double step = drift_ratio;
+    if (fill_target >= 0) {
+        step += (fill_smoothed - fill_target) / (AR * DRIFT_TAU);
+    }
+    step = MAX(1 - DRIFT_MAX, MIN(1 + DRIFT_MAX, step));
+
+    // make sure stage has frames through floor(last position) + 2:
+    int need = (int) (rs_pos + step * (BL - 1)) + 3;
+    while (stage_frames < need) {
+        if (buffer.get_fifo_len() == 0) {
+            arco_print("o2audioio: underflow, id %d\n", id);
+            block_zero_n(out_samps, chans);
+            return;
+        }
+        Sample *block = stage_block.get_array();
+        if (floattype) {
+            buffer.dequeue((char *) block);
+        } else {
+            buffer.dequeue_16bit(block);
+        }
+        for (int ch = 0; ch < chans; ch++) {
+            memcpy(&stage[ch * DRIFT_STAGE + stage_frames], block + ch * BL,
+                   BL * sizeof(Sample));
+        }
+        stage_frames += BL;
+    }
+
+    // positions relative to base are small, so float is accurate enough:
+    int base = (int) rs_pos;
+    float frac0 = (float) (rs_pos - base);
+    float fstep = (float) step;
+    int32_t ix[BL];
+    float frac[BL];
+    for (int i = 0; i < BL; i++) {
+        float p = frac0 + fstep * i;
+        int32_t k = (int32_t) p;
+        ix[i] = base + k;
+        frac[i] = p - k;
+    }
+    for (int ch = 0; ch < chans; ch++) {
+        Sample *x = &stage[ch * DRIFT_STAGE];
+        Sample *out = out_samps + ch * BL;
+        Sample xm1[BL], x0[BL], x1[BL], x2[BL];
+        for (int i = 0; i < BL; i++) {  // gather
+            Sample *s = x + ix[i];
+            xm1[i] = s[-1];
+            x0[i] = s[0];
+            x1[i] = s[1];
+            x2[i] = s[2];
+        }
+        for (int i = 0; i < BL; i++) {  // cubic Hermite interpolation
+            float c1 = 0.5f * (x1[i] - xm1[i]);
+            float c2 = xm1[i] - 2.5f * x0[i] + 2 * x1[i] - 0.5f * x2[i];
+            float c3 = 0.5f * (x2[i] - xm1[i]) + 1.5f * (x0[i] - x1[i]);
+            float f = frac[i];
+            out[i] = ((c3 * f + c2) * f + c1) * f + x0[i];
+        }
+    }
+
+    // advance and discard frames that are no longer needed, keeping one
+    // frame before the next position for interpolation:
+    rs_pos += step * BL;
+    int drop = (int) rs_pos - 1;
+    if (drop > 0) {
+        for (int ch = 0; ch < chans; ch++) {
+            Sample *x = &stage[ch * DRIFT_STAGE];
+            memmove(x, x + drop, (stage_frames - drop) * sizeof(Sample));
+        }
+        stage_frames -= drop;
+        rs_pos -= drop;
+    }
+}
+
+
 /* O2SM INTERFACE: /arco/o2aud/new
        int32 id,
        int32 recvchans,
@@ -86,10 +613,62 @@ void arco_o2aud_data(O2SM_HANDLER_ARGS)
     // end unpack message
 
     UGEN_FROM_ID(O2audioio, o2audioio, id, "arco_o2aud_data");
+    if (o2audioio->coded) {  // decode on the main thread
+        if (o2audioio->has_output) {
+            offload(O2aud_decode_job::get(o2audioio, when, framecount,
+                                          samps));
+        }
+        return;
+    }
     o2audioio->data(when, framecount, samps);
 }
 
 
+/* O2SM INTERFACE: /arco/o2aud/drift int32 id, bool drift;
+ */
+static void arco_o2aud_drift(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    bool drift = argv[1]->B;
+    // end unpack message
+
+    UGEN_FROM_ID(O2audioio, o2audioio, id, "arco_o2aud_drift");
+    o2audioio->set_drift(drift);
+}
+
+
+/* O2SM INTERFACE: /arco/o2aud/adapt int32 id, bool adapt, int32 min,
+       int32 max;
+ */
+static void arco_o2aud_adapt(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    bool adapt = argv[1]->B;
+    int32_t min = argv[2]->i;
+    int32_t max = argv[3]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(O2audioio, o2audioio, id, "arco_o2aud_adapt");
+    o2audioio->set_adapt(adapt, min, max);
+}
+
+
+/* O2SM INTERFACE: /arco/o2aud/stats int32 id, string reply_addr;
+ */
+static void arco_o2aud_stats(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    char *reply_addr = argv[1]->s;
+    // end unpack message
+
+    UGEN_FROM_ID(O2audioio, o2audioio, id, "arco_o2aud_stats");
+    o2audioio->stats(reply_addr);
+}
+
+
 /* O2SM INTERFACE: /arco/o2aud/hello int32 id;
  */
 void arco_o2aud_hello(O2SM_HANDLER_ARGS)
@@ -117,6 +696,12 @@ static void o2audioio_init()
                     true);
     o2sm_method_new("/arco/o2aud/hello", "i", arco_o2aud_hello, NULL, true,
                     true);
+    o2sm_method_new("/arco/o2aud/drift", "iB", arco_o2aud_drift, NULL, true,
+                    true);
+    o2sm_method_new("/arco/o2aud/adapt", "iBii", arco_o2aud_adapt, NULL,
+                    true, true);
+    o2sm_method_new("/arco/o2aud/stats", "is", arco_o2aud_stats, NULL, true,
+                    true);
     // END INTERFACE INITIALIZATION
 }
 
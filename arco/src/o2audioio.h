@@ -117,7 +117,9 @@ Output messages:
         is sent when o2audioio is created and also in response to a 
         /hello message. destchans refers to the number of O2audioio input
         channels, which is the number of channels sent from Arco to
-        <destaddr>/data. sampletype is 0 for int16 and 1 for float.
+        <destaddr>/data. sampletype is 0 for int16, 1 for float and 2
+        for coded int16 (see "Coded samples" below), plus 4 if int16
+        or float samples are little-endian (see "Sending" below).
     <destaddr>/enab "iBth" id enab timestamp framecount
         is sent when the stream starts (enab = 1) or stops (enab = 0).
         timestamp is the O2 time corresponding to framecount
@@ -125,7 +127,7 @@ Output messages:
         is sent as audio becomes available, in chunks of msgsize frames,
         where msgsize is a parameter to the O2audioio constructor. The
         receiver can compute msgsize from the blob size, the sampletype,
-        and destchans.
+        and destchans (except for coded blobs, where the size varies).
     <destaddr>/hello "i" id
         is sent every 3 seconds while the stream is enabled but blocked.
         The response (if there is a receiver) should be an identical
@@ -136,10 +138,97 @@ Messages to O2audioio objects:
 When the stream starts, the audio process we are connected to can
 start sending audio, either after processing audio from an O2audioio
 source, or simply by generating and sending audio. In the case of just
-sending audio, there are currently no corrections for sample rate
-discrepancies, and the sender must not overflow the buffer set by
+sending audio, the sender must not overflow the buffer set by
 buffsize. Arco generally provides the reference clock which is based
-on samples, so O2 time and sample count should stay in synchrony.
+on samples, so O2 time and sample count should stay in synchrony. If
+the sender has its own audio clock, enable drift compensation (below).
+
+Clock drift:
+
+A sender with its own audio clock (e.g. a remote peer with an audio
+device) produces frames at a slightly different rate. Without
+correction, its framecounts drift away from frame_count, so the buffer
+slowly overflows (messages are "late" and dropped) or underflows
+(zeros are output). /arco/o2aud/drift ID 1 enables drift compensation
+on the receive path:
+
+  - Incoming frames are treated as a continuous stream: gaps in
+    framecount are zero-filled, but framecount is not aligned to
+    frame_count. The queue has room for 2 * buffsize frames (plus a
+    message) so the fill level can wander.
+  - Once per second (at most), a /data message contributes a point
+    (when, framecount, now, frame_count). Over up to DRIFT_POINTS
+    points, the sender rate is d(framecount)/d(when) and our rate is
+    d(frame_count)/d(now), both in frames per O2 second, so the
+    ratio is an estimate of sender frames per output frame that is
+    not affected by network jitter.
+  - Output is resampled from the queue by a 4-point (cubic Hermite)
+    fractional resampler stepping by the ratio plus a small
+    correction proportional to the (smoothed) difference between the
+    fill level and the fill level when the estimate first became
+    valid. The correction keeps latency constant; the ratio keeps the
+    correction small. The step is limited to 1 +/- DRIFT_MAX.
+
+Drift compensation is off by default because when the remote process
+just returns processed Arco audio, framecounts are already in our
+clock and output is exactly aligned to input.
+
+Adaptive buffer size:
+
+buffsize must cover the worst-case arrival jitter, which means high
+latency on a good network. /arco/o2aud/adapt ID 1 min max lets the
+latency (buffer_frames_max) follow the network, staying between min
+and max frames, while framecount alignment is preserved (output is
+always input delayed by exactly buffer_frames_max):
+
+  - On each /data message, the frames still queued ("slack") are
+    noted, and the inter-arrival jitter is estimated as in RFC 3550:
+    jitter += (|D| - jitter) / 16, where D is the change in transit
+    time (now - when) from the previous message.
+  - Every ADAPT_PERIOD seconds, the margin is BL plus ADAPT_JITTER
+    times the jitter (in frames). If the minimum slack in the period
+    was below the margin, the buffer grows by one block; if it was
+    more than the margin plus 2 blocks, it shrinks by one block.
+  - An underflow grows the buffer by one block immediately (the late
+    data is kept rather than dropped), and shrinking is then held off
+    for ADAPT_HOLD seconds.
+  - To grow, the head block is output twice, crossfading from the
+    block that follows it back to the head block. To shrink, one
+    block is skipped, crossfading from the head to the next block.
+
+Drift compensation (above) holds its own fill level, so adaptive
+sizing applies only when drift compensation is off.
+
+/arco/o2aud/stats ID reply_addr sends statistics to reply_addr (see
+API). The report printed every 3 seconds includes them as well.
+
+Coded samples:
+
+Raw int16 audio takes about 1.4 Mbit/s per channel at 44.1 kHz. With
+sampletype 2, blobs in both directions contain int16 samples coded by
+a lossless predictive coder (see audioblob.h), which typically saves
+25 to 50 percent, so more channels fit over a constrained link. Each
+message is coded on its own, so there is no added latency beyond
+msgsize and dropped messages do not affect others. Coding and decoding run on the
+main thread (see offload.h), not the audio thread: a full outgoing
+blob is copied to a job that codes it, and the audio thread sends the
+coded blob when the job finishes; an incoming coded blob is copied to
+a job that decodes it, and the audio thread handles the samples as a
+/data message when the job finishes. Jobs and their buffers are reused
+rather than allocated for each message. This delays messages by about
+one main thread polling period in each direction, so buffsize should
+allow for it.
+
+Sending:
+
+Uncoded samples are written directly into an outgoing /data message
+as each block is computed (see Audioblob in audioblob.h): conversion
+to int16 and byte swapping happen in that one pass, and the message
+is handed to O2 without copying. Message memory comes from a
+Bufferpool that the main thread refills. Samples are big-endian
+(network order) unless sampletype includes SAMPLETYPE_LITTLE (4), in
+which case they are little-endian in both directions. Little-endian
+peers (almost all hosts) can use this to avoid swapping at both ends.
 
 Messages are sent to /arco/o2aud/data, and the first parameter names
 the destination O2audioio Ugen object.
@@ -153,7 +242,8 @@ API
         output is stopped immediately, which will truncate the last
         buffersize frames.
     /arco/o2aud/data "ithb" id when framecount sampleblob
-        is sent only from the remote audio source. framecount matches
+        is sent only from the remote audio source. sampleblob is coded
+        if sampletype is 2. framecount matches
         the frame count of the input samples that were processed so it
         will normally be greater than the current O2audioio object's 
         input frame count. when is the actual O2time when the message
@@ -165,8 +255,41 @@ API
         /prep and /enab, and resume sending /data messages (unless
         sending has been stopped, in which case /prep is sent followed
         by /enab with enab = false).
+    /arco/o2aud/drift "iB" id drift
+        enables or disables drift compensation (see "Clock drift"
+        above). If the stream is running, it is restarted as if by
+        /hello.
+    /arco/o2aud/adapt "iBii" id adapt min max
+        enables or disables adaptive buffer sizing (see "Adaptive
+        buffer size" above). min and max are latency limits in frames,
+        rounded to multiples of BL. max is limited by the space
+        allocated for the queue (2 * buffsize).
+    /arco/o2aud/stats "is" id reply_addr
+        requests statistics, which are sent to reply_addr with types
+        "iiifiB": id, latency (buffer_frames_max), min slack in frames
+        since the last periodic report, jitter in seconds, number of
+        underflows, and whether adaptive sizing is enabled.
 */
 
+#define DRIFT_POINTS 64       // history for the drift estimate
+#define DRIFT_MIN_POINTS 5    // points needed before estimating
+#define DRIFT_INTERVAL 1.0    // minimum seconds between points
+#define O2AUD_JOB_RESERVE 4   // coding jobs of each kind kept per stream
+#define DRIFT_TAU 10.0        // time constant to correct fill level
+#define DRIFT_MAX 0.005       // maximum deviation of step from 1
+#define DRIFT_STAGE (4 * BL)  // frames of resampler input per channel
+
+#define ADAPT_PERIOD 1.0      // seconds between buffer size decisions
+#define ADAPT_JITTER 4.0      // margin in units of jitter
+#define ADAPT_HOLD 10.0       // seconds without shrinking after underflow
+
+struct Drift_point {
+    double when;         // sender's O2 time
+    int64_t framecount;  // sender's frame count at when
+    double now;          // our O2 time when the message was handled
+    int64_t frame_count; // our frame count at now
+};
+
 extern const char *O2audioio_name;
 
 void arco_o2audioio_init();
@@ -208,7 +331,10 @@ public:
     // is consistent.
     int64_t next_buffer_frame;
 
+    int32_t sampletype;  // as given to the constructor
     bool floattype;  // 0 for int16, 1 for float
+    bool coded;      // int16 samples are coded in messages (sampletype 2)
+    bool recv_swap;  // received samples need byte swapping
     int input_chans;
     Ugen_ptr input;
     int input_stride;
@@ -220,6 +346,34 @@ public:
     int min_buffer_len;
     int64_t last_report_frame_count;
 
+    // drift compensation (see "Clock drift" above):
+    bool drift;               // resample received audio?
+    bool recv_started;        // is next_recv_frame valid?
+    int64_t next_recv_frame;  // sender frame count of next frame to enqueue
+    Drift_point drift_points[DRIFT_POINTS];
+    int drift_count;          // number of valid points
+    int drift_next;           // where to store the next point
+    double drift_ratio;       // estimated sender frames per output frame
+    double fill_smoothed;     // queued frames, lowpass filtered
+    double fill_target;       // fill level to maintain, < 0 if unknown
+    Vec<Sample> stage;        // resampler input, DRIFT_STAGE per channel
+    Vec<Sample> stage_block;  // one block from buffer, converted
+    int stage_frames;         // frames in stage (per channel)
+    double rs_pos;            // resampler position in stage
+
+    // adaptive buffer size (see "Adaptive buffer size" above):
+    bool adaptive;
+    int adapt_min;            // latency limits in frames
+    int adapt_max;
+    int adapt_step;           // +1 to grow, -1 to shrink at next block
+    bool adapt_xfade;         // second block of growing
+    int window_slack;         // min frames queued at arrival this period
+    int64_t adapt_frame;      // frame_count of next decision
+    int64_t hold_frame;       // no shrinking before this frame_count
+    double jitter;            // inter-arrival jitter in seconds
+    double last_transit;      // transit time of previous message, or -1
+    int underflows;
+
 
     const char *classname() { return O2audioio_name; }
 
@@ -249,15 +403,16 @@ public:
         o2sm_add_int32(input_chans);
         o2sm_add_int32(chans);
         o2sm_add_float(AR);
-        o2sm_add_int32(floattype);
+        o2sm_add_int32(sampletype);
         o2sm_send_finish(0, prepaddr, true);
     }
     
 
     O2audioio(int32_t id,  int32_t recvchans, Ugen_ptr input,
               char *destaddr, int32_t destchans, int32_t buffsize,
-              int32_t sampletype, int32_t msgsize) :
-        out_blob(sampletype, destchans, ((msgsize + BL - 1) / BL) * BL),
+              int32_t sampletype_, int32_t msgsize) :
+        out_blob((sampletype_ & 3) == 1, destchans,
+                 ((msgsize + BL - 1) / BL) * BL),
         Ugen(id, 'a', recvchans) {
     // Create the Ugen O2audioio, which sends input to a destination via O2
     //     and outputs audio that is received via O2
@@ -269,7 +424,8 @@ public:
     //     destaddr - base address for outgoing O2 messages with audio data.
     //     destchans - how many channels to send via O2 (0 for none)
     //     buffsize - size in frames to buffer incoming audio messages
-    //     sampletype - 0 for int16 and 1 for float
+    //     sampletype - 0 for int16, 1 for float, 2 for coded int16,
+    //                  plus SAMPLETYPE_LITTLE for little-endian samples
     //     msgsize - size in frames of O2 audio messages
     //
     // destaddr is appended with "/data" to form an O2 address for audio
@@ -285,7 +441,11 @@ public:
         restart_frame_count = 0;  // when blocked, set this to frame_count
 
         frame_count = 0;
-        floattype = (sampletype == 1);
+        sampletype = sampletype_;
+        floattype = ((sampletype & 3) == 1);
+        coded = ((sampletype & 3) == SAMPLETYPE_CODED);
+        bool little = (sampletype & SAMPLETYPE_LITTLE) != 0;
+        recv_swap = !coded && (little != IS_LITTLE_ENDIAN);
         has_input = (destchans > 0);
         has_output = (recvchans > 0);
         input_chans = destchans;
@@ -299,22 +459,42 @@ public:
             dest_addr_base[dest_addr_base_len] = 0;  // EOS
         }
         init_input(input);
+        if (has_input && !coded) {  // build messages in place
+            out_blob.use_messages(complete_address("data"), id, little);
+        }
 
         min_buffer_len = 0;  // give it an initial value even if unused
         last_report_frame_count = 0;
+        running = false;
+        drift = false;
+        adaptive = false;
+        adapt_min = 0;
+        adapt_max = 0;
+        underflows = 0;
+        jitter = 0;
 
         if (has_output) {  // receive from r
             // blocksize is size in bytes of BL frames (of int16 or float):
-            int blocksize = BL * recvchans * 2 * (sampletype + 1);
+            int blocksize = BL * recvchans * 2 * (floattype + 1);
             // buffsize = size in frames to buffer incoming audio messages
             buffsize = (buffsize + BL - 1) / BL;  // round up
             // buffsize is now number of blocks (each block is BL frames)
-            // that should fit in queue
-            buffer.init(blocksize, buffsize, true);
+            // that should fit in queue. Allocate room for twice that
+            // plus a message for drift compensation:
+            buffer.init(blocksize, 2 * buffsize + out_blob.frames / BL);
+            buffer.zero_fill(buffsize);
             assert(buffer.get_fifo_len() == buffsize);
             buffer_frames_max = buffsize * BL;
             next_buffer_frame = buffer_frames_max;
             min_buffer_len = buffer_frames_max;
+            stage.set_size(DRIFT_STAGE * chans);
+            stage_block.set_size(BL * chans);
+            reset_drift();
+            reset_adapt();
+        }
+
+        if (coded) {
+            reserve_jobs(O2AUD_JOB_RESERVE);
         }
 
         send_prep();
@@ -325,17 +505,30 @@ public:
     ~O2audioio() {
         // ahprintf("o2audioio destroy@%p id %d refcnt %d\n", this, id, refcount);
         if (dest_addr_base) O2_FREE(dest_addr_base);
+        if (coded) {
+            reserve_jobs(-O2AUD_JOB_RESERVE);
+        }
         // buffer is freed by destructor
     }
 
     
     void data(double when, int64_t framecount, O2blob_ptr samps) {
     // handle incoming audio samples message
+        if (drift) {
+            data_drift(when, framecount, samps);
+            return;
+        }
         assert(next_buffer_frame ==
                frame_count + buffer.get_fifo_len() * BL);
         double now = o2sm_time_get();
         int inq = buffer.get_fifo_len() * BL;
         min_buffer_len = MIN(min_buffer_len, inq);
+        window_slack = MIN(window_slack, inq);
+        double transit = now - when;
+        if (last_transit >= 0) {
+            jitter += (fabs(transit - last_transit) - jitter) * 0.0625;
+        }
+        last_transit = transit;
         // test if contiguous with what is in queue:
         if (framecount + buffer_frames_max < next_buffer_frame) {
             return;  // this message is late, throw it out
@@ -351,8 +544,10 @@ public:
 
         // insert data from message
         assert(samps->size == out_blob.frames * chans * 2 * (floattype + 1));
-        // fix byte order if necessary
-        blob_byteswap(samps->data, out_blob.frames, chans, floattype);
+        // fix byte order if necessary (decoded blobs are in host order):
+        if (recv_swap) {
+            blob_swap(samps->data, out_blob.frames, chans, floattype);
+        }
         assert(buffer.size() - buffer.get_fifo_len() >=
                out_blob.frames / BL);
         for (int frames = 0; frames < out_blob.frames; frames += BL) {
@@ -362,10 +557,12 @@ public:
 
         if (last_report_frame_count + AR * 3 <= frame_count) {
             arco_print("O2audioio %d min-buf-frms %d (%gs) "
-                "max-lat %gs max-rnd-trip %gs\n", id, min_buffer_len,
+                "max-lat %gs max-rnd-trip %gs latency %d jitter %gms "
+                "underflows %d\n", id, min_buffer_len,
                 min_buffer_len * AP,
                 (buffer_frames_max - min_buffer_len) * AP,
-                (buffer_frames_max - out_blob.frames - min_buffer_len) * AP);
+                (buffer_frames_max - out_blob.frames - min_buffer_len) * AP,
+                buffer_frames_max, jitter * 1000, underflows);
             min_buffer_len = buffer_frames_max;
             last_report_frame_count = frame_count;
         }
@@ -385,7 +582,7 @@ public:
     
     void hello() {
     // handle hello message by resending prep and enab messages
-        out_blob.next = 0;  // empty output message
+        out_blob.clear();  // empty output message
         // empty buffer
         send_prep();
         if (running) {
@@ -407,16 +604,17 @@ public:
 
 
     void send_enab() {
-        if (running) {
-            buffer.zero_fill(buffer.size());
+        if (running && has_output) {
+            buffer.zero_fill(buffer_frames_max / BL);
             next_buffer_frame = frame_count + buffer_frames_max;
             // ahprintf("send_enab: fifo_len %d frame_count %lld "
             //          "next_buffer_frame %lld\n", buffer.get_fifo_len(),
             //          frame_count, next_buffer_frame);
-            assert(buffer.get_fifo_len() * buffer.blocksize /* bytes */ ==
-                   buffer_frames_max * 2 * (floattype + 1)  /* bytes */ );
+            assert(buffer.get_fifo_len() * BL == buffer_frames_max);
             assert(next_buffer_frame ==
                    frame_count + buffer.get_fifo_len() * BL);
+            reset_drift();
+            reset_adapt();
         }
         const char *enab_addr = complete_address("enab");
         o2sm_send_start();
@@ -436,6 +634,77 @@ public:
             send_enab();
         }
     }
+
+
+    void set_drift(bool d) {
+    // handle /arco/o2aud/drift message
+        if (drift != d && has_output) {
+            drift = d;
+            reset_drift();
+            if (running) {
+                send_enab();  // restart with empty buffer
+            }
+        }
+    }
+
+
+    void reset_drift() {
+        recv_started = false;
+        drift_count = 0;
+        drift_next = 0;
+        drift_ratio = 1.0;
+        fill_smoothed = buffer_frames_max;
+        fill_target = -1;
+        stage.zero();
+        stage_frames = 1;  // one frame of history for interpolation
+        rs_pos = 1.0;
+    }
+
+
+    void set_adapt(bool a, int lo, int hi) {
+    // handle /arco/o2aud/adapt message
+        if (!has_output) {
+            return;
+        }
+        // the queue holds 2 * buffsize frames plus one message:
+        int limit = buffer.size() * BL - out_blob.frames;
+        adapt_min = MAX(BL, (lo / BL) * BL);
+        adapt_max = MIN(limit, ((hi + BL - 1) / BL) * BL);
+        adapt_max = MAX(adapt_max, adapt_min);
+        adaptive = a;
+        reset_adapt();
+    }
+
+
+    void reset_adapt() {
+        adapt_step = 0;
+        adapt_xfade = false;
+        window_slack = INT_MAX;
+        adapt_frame = frame_count + (int64_t) (ADAPT_PERIOD * AR);
+        hold_frame = 0;
+        last_transit = -1;
+    }
+
+
+    void adapt_check();
+
+    bool adapt_output();
+
+    void peek_block(int n, Sample *dst);
+
+    void stats(const char *reply_addr);
+
+    void data_drift(double when, int64_t framecount, O2blob_ptr samps);
+
+    void send_coded(int64_t framecount);
+
+    void reserve_jobs(int n);
+
+    void send_data(double when, int64_t framecount, O2blob_ptr samps);
+
+    void drift_observe(double when, int64_t framecount);
+
+    void run_drift();
             
     
     void real_run() {
@@ -452,7 +721,7 @@ public:
             if (out_blob.is_full()) {  // send 'em
                 if (buffer.get_fifo_len() == 0) {
                     // have not received what we sent for too long
-                    out_blob.next = 0;  // clear the blob, drop the samples
+                    out_blob.clear();  // drop the samples
                     if (blocked_state == 0) {
                         blocked_state = 1;
                         send_hello();
@@ -467,22 +736,29 @@ public:
                         (frame_count - restart_frame_count > AR * 3)) {
                         blocked_state = 0;
                     }
-                    const char *data_addr = complete_address("data");
-                    o2sm_send_start();
-                    o2sm_add_int32(id);
-                    o2sm_add_time(o2sm_time_get());
                     // compute the frame count of the first frame in blob:
-                    o2sm_add_int64(frame_count + BL - out_blob.frames);
-                    out_blob.add_blob();
-                    o2sm_send_finish(0, data_addr, true);
+                    int64_t first_frame = frame_count + BL - out_blob.frames;
+                    if (coded) {
+                        send_coded(first_frame);
+                    } else {  // samples are already in a message
+                        o2sm_message_send(out_blob.finish_message(
+                                o2sm_time_get(), first_frame));
+                    }
                 }
             }
         }
-        if (has_output) {
+        if (has_output && drift) {
+            run_drift();
+        } else if (has_output) {
             // printf("o2audioio output: frame_count %lld fifo_len %d "
             //        "next_buffer_frame %lld\n",
             //        frame_count, buffer.get_fifo_len(), next_buffer_frame);
-            if (buffer.get_fifo_len() > 0) {
+            if (adaptive) {
+                adapt_check();
+            }
+            if (adaptive && adapt_output()) {
+                ;  // output computed while changing the buffer size
+            } else if (buffer.get_fifo_len() > 0) {
                 if (floattype) {
                     assert(buffer.blocksize == chans * BL * sizeof(float));
                     buffer.dequeue((char *) out_samps);
@@ -497,6 +773,12 @@ public:
                 assert(output.size() >= BL * chans);
                 block_zero_n(output.get_array(), chans);
                 next_buffer_frame += BL;
+                underflows++;
+                if (adaptive && buffer_frames_max < adapt_max) {
+                    // grow so that the late data is still used:
+                    buffer_frames_max += BL;
+                    hold_frame = frame_count + (int64_t) (ADAPT_HOLD * AR);
+                }
             }
         }
         frame_count += BL;
@@ -0,0 +1,59 @@
+/* offload.cpp -- run expensive work for the audio thread on the main thread
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "o2atomic.h"
+#include "offload.h"
+
+static O2queue offload_todo;  // jobs to run, newest first
+static O2queue offload_done;  // jobs to finish, newest first
+
+
+// O2queue is a stack, so reverse a list of links to get oldest first
+static Offload_link *offload_reverse(Offload_link *link)
+{
+    Offload_link *result = NULL;
+    while (link) {
+        Offload_link *next = link->next;
+        link->next = result;
+        result = link;
+        link = next;
+    }
+    return result;
+}
+
+
+void offload(Offload_job *job)
+{
+    offload_todo.push((O2list_elem *) &job->link);
+}
+
+
+void offload_run()
+{
+    Offload_link *link = offload_reverse((Offload_link *)
+                                         offload_todo.grab());
+    while (link) {
+        Offload_link *next = link->next;
+        link->job->run();
+        offload_done.push((O2list_elem *) link);
+        link = next;
+    }
+}
+
+
+void offload_finish()
+{
+    Offload_link *link = offload_reverse((Offload_link *)
+                                         offload_done.grab());
+    while (link) {
+        Offload_link *next = link->next;
+        Offload_job *job = link->job;
+        job->finish();
+        job->release();
+        link = next;
+    }
+}
@@ -0,0 +1,58 @@
+/* offload.h -- run expensive work for the audio thread on the main thread
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Some requests, e.g. building a large wavetable, take too long to
+ * run in a message handler on the audio thread. Instead, the handler
+ * creates an Offload_job and calls offload(job). The main thread runs
+ * job->run() from arco_thread_poll(), then the audio thread calls
+ * job->finish() before computing the next block and then
+ * job->release(), which deletes the job unless the job class keeps
+ * jobs for reuse so that the audio thread does not allocate them.
+ *
+ * Jobs run and finish in the order they are offloaded. run() must not
+ * touch audio thread data, and finish() should be quick, e.g. swap a
+ * pointer to publish a result. A job that refers to a Ugen should
+ * ref() it when created and unref() it in finish() so the Ugen is not
+ * deleted while the main thread is working.
+ */
+
+#ifndef OFFLOAD_H
+#define OFFLOAD_H
+
+class Offload_job;
+
+struct Offload_link {  // an O2list_elem that can find its job
+    Offload_link *next;
+    Offload_job *job;
+};
+
+
+class Offload_job : public O2obj {
+  public:
+    Offload_link link;  // to put job on an O2queue
+
+    Offload_job() { link.next = NULL; link.job = this; }
+
+    virtual ~Offload_job() { }
+
+    virtual void run() = 0;     // called by the main thread
+
+    virtual void finish() = 0;  // called by the audio thread after run()
+
+    virtual void release() { delete this; }  // audio thread, after finish()
+};
+
+
+// queue job to run on the main thread (audio thread)
+void offload(Offload_job *job);
+
+// run offloaded jobs (main thread)
+void offload_run();
+
+// finish jobs that have run and release them (audio thread)
+void offload_finish();
+
+#endif
@@ -184,7 +184,9 @@ class Ola_pitch_shift: public Ugen {
         if (iwindur < ixfade * 2) {
             iwindur = ixfade * 2;
         }
-        int bl = iwindur + 1;  // bl = delay buffer len in samples
+        // bl = delay buffer len in samples; BL extra because we write
+        // a block before reading any taps:
+        int bl = iwindur + 1 + BL;
         for (int i = 0; i < chans; i++) {
             Ola_pitch_shift_state *state = &states[i];
             state->delaybuf.set_fifo_len(bl, true);
@@ -199,10 +201,14 @@ class Ola_pitch_shift: public Ugen {
 
     void chan_a(Ola_pitch_shift_state *state) {
         Ringbuf &delaybuf = state->delaybuf;
+        // write the whole input block first. At sample i, get_nth(n) in
+        // a one-sample-at-a-time loop becomes get_nth(n + back) where
+        // back = BL - 1 - i is the count of samples enqueued "early":
+        delaybuf.toss(BL);  // make room for more
+        delaybuf.enqueue_block(input_samps);
 
         for (int i = 0; i < BL; i++)  {
-            delaybuf.toss(1);  // make room for mor
-            delaybuf.enqueue(input_samps[i]);
+            int back = BL - 1 - i;
 
             // adjust fouttap_delta to the range -(iwindur-ixfade) to 0.
             // when it exceeds either extreme, we wrap around, and due
@@ -221,8 +227,8 @@ class Ola_pitch_shift: public Ugen {
             // fouttap is an offset from input (tail) and it is negative.
             // get_nth(n) goes back to nth previous sample, n is positive.
             // so we have to flip the sign by using -tap1a and -tap2a
-            float x1a = delaybuf.get_nth(-tap1a);
-            float x2a = delaybuf.get_nth(-tap2a);
+            float x1a = delaybuf.get_nth(back - tap1a);
+            float x2a = delaybuf.get_nth(back - tap2a);
             float xa = x1a +  alpha * (x2a - x1a);
          
             if (fouttap_delta < -ixfade) { 
@@ -230,8 +236,8 @@ class Ola_pitch_shift: public Ugen {
             } else {
                 int tap1b = tap1a - (iwindur - ixfade);
                 int tap2b = tap1b + 1;
-                float x1b = delaybuf.get_nth(-tap1b);
-                float x2b = delaybuf.get_nth(-tap2b);
+                float x1b = delaybuf.get_nth(back - tap1b);
+                float x2b = delaybuf.get_nth(back - tap2b);
                 // note that since we are at an integer offset, the fractional
                 // part of tap1b is alpha, the fractional part of tap1a
                 float xb = x1b + alpha * (x2b - x1b);
@@ -25,6 +25,8 @@ class Onset : public Ugen {
     
     // one for each channel
     Vec<Sample_ptr> frames;
+    Vec<Sample> onsets;  // 1 if channel had an onset in the last frame
+    int feature_frames;  // count of frames (see get_features())
     LPSpectralDifferenceODF** odfs;
     RTOnsetDetection** detectors;
     
@@ -45,6 +47,8 @@ class Onset : public Ugen {
         odfs = O2_MALLOCNT(input_chans, LPSpectralDifferenceODF*);
         detectors = O2_MALLOCNT(input_chans, RTOnsetDetection*);
         frames.init(input_chans, false, true);
+        onsets.set_size(input_chans);
+        feature_frames = 0;
         for (int i = 0; i < input_chans; i++) {
             // reuse already allocated objects if possible:
             if (old_odfs.size() > 0) {
@@ -114,15 +118,26 @@ class Onset : public Ugen {
         //compute odf if we have full frame
         for (int i = 0; i < input_chans; i++){
             float odf_res = odfs[i]->process_frame(frame_size, frames[i]);
-            if (detectors[i]->is_onset(odf_res)) {
+            bool onset = detectors[i]->is_onset(odf_res);
+            onsets[i] = (onset ? 1.0f : 0.0f);
+            if (onset && address[0]) {
                 o2sm_send_start();
                 o2sm_add_int32(id);
                 o2sm_add_int32(i); // send which channel
                 o2sm_send_finish(0, address, false);
             }
         }
+        feature_frames++;
         samps_stored = 0;
     }
+
+
+    // features are 1 (onset) or 0 for each channel
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = &onsets[0];
+        *frame_count = feature_frames;
+        return input_chans;
+    }
 };
 
 Vec<LPSpectralDifferenceODF*> Onset::old_odfs;
@@ -9,6 +9,7 @@
 #include "sharedmem.h"
 #include "const.h"
 #include "audioblock.h"
+#include "bufferpool.h"
 #include "probe.h"
 
 const char *Probe_name = "Probe";
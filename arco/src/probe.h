@@ -56,6 +56,10 @@
 #define PROBE_COLLECTING 2
 #define PROBE_DELAYING 3
 
+// largest message: msg_header plus id and 64 floats, in samples:
+#define PROBE_MSG_MAX ((160 + 4 * 65) / 4)
+#define PROBE_RESERVE 4  // pooled messages to keep available
+
 extern const char *Probe_name;
 
 class Probe : public Ugen {
@@ -73,6 +77,7 @@ class Probe : public Ugen {
     int msg_len;
     Sample *sample_ptr;    // samples are accumulated here
     Sample *sample_fence;  // address beyond last sample in message
+    Bufferpool *msg_pool;  // messages are allocated from here
 
     float period;     // how often to send samples
     int frames;       // requested number of samples per period - this
@@ -128,6 +133,10 @@ class Probe : public Ugen {
         direction = 1;
         max_wait = 0.02;
         prev_sample = 0.0;
+        // preallocated messages avoid calling the allocator from the
+        // audio thread (see bufferpool.h):
+        msg_pool = bufferpool_pow2(PROBE_MSG_MAX);
+        msg_pool->reserve(PROBE_RESERVE);
 
         init_input(input);
     }
@@ -136,6 +145,7 @@ class Probe : public Ugen {
     ~Probe() {
         // ahprintf("~Probe destructor called, id %d; does nothing.\n", id);
         input->unref(&input);
+        msg_pool->reserve(-PROBE_RESERVE);
     }
 
     const char *classname() { return Probe_name; }
@@ -177,7 +187,10 @@ class Probe : public Ugen {
     }
 
     void prepare_msg() {
-        msg = (O2message_ptr) O2_MALLOC(msg_len);
+        msg = (O2message_ptr) msg_pool->get();
+        if (!msg) {  // pool is empty, so allocate
+            msg = (O2message_ptr) O2_MALLOC(msg_len);
+        }
         memcpy(msg, msg_header, msg_header_len);
         sample_ptr = (float *) (((char *) msg) + msg_header_len);
         sample_fence = (float *) (((char *) msg) + msg_len);
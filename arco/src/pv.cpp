@@ -63,6 +63,20 @@ void arco_pv_ratio(O2SM_HANDLER_ARGS)
 }
 
 
+/* O2SM INTERFACE: /arco/pv/linked int32 id, bool linked;
+ */
+void arco_pv_linked(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    bool linked = argv[1]->B;
+    // end unpack message
+
+    UGEN_FROM_ID(Pv, pv, id, "arco_pv_linked");
+    pv->set_linked(linked);
+}
+
+
 /* O2SM INTERFACE: /arco/pv/repl_input int32 id, int32 input_id;
  */
 void arco_pv_repl_input(O2SM_HANDLER_ARGS)
@@ -85,6 +99,8 @@ static void pv_init()
     o2sm_method_new("/arco/pv/stretch", "if", arco_pv_stretch, NULL, true,
                     true);
     o2sm_method_new("/arco/pv/ratio", "if", arco_pv_ratio, NULL, true, true);
+    o2sm_method_new("/arco/pv/linked", "iB", arco_pv_linked, NULL, true,
+                    true);
     o2sm_method_new("/arco/pv/repl_input", "ii", arco_pv_repl_input, NULL,
                     true, true);
     // END INTERFACE INITIALIZATION
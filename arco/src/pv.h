@@ -16,6 +16,7 @@ class Pv: public Ugen {
     int hopsize;
     float ratio;
     int mode;
+    bool linked;  // channels share channel 0's phase-locking (mode 1)
     float stretch;  // time stretch factor
     bool use_stretch;  // use stretch to control when to read input
     // (use_stretch is true iff input is a Fileplay Ugen).
@@ -52,6 +53,7 @@ class Pv: public Ugen {
         fftsize = fftsize_;
         hopsize = hopsize_;
         mode = mode_;
+        linked = false;
         states.set_size(chans);
         for (int i = 0; i < chans; i++) {
             states[i].inputbuf.init(fftsize * 2);
@@ -109,8 +111,9 @@ class Pv: public Ugen {
     
 
     void print_details(int indent) {
-        arco_print("ratio %g fftsize %d hopsize %d points %d mode %d",
-                   ratio, fftsize, hopsize, points, mode);
+        arco_print("ratio %g fftsize %d hopsize %d points %d mode %d%s",
+                   ratio, fftsize, hopsize, points, mode,
+                   linked ? " linked" : "");
     }
 
 
@@ -158,6 +161,22 @@ class Pv: public Ugen {
     }
 
 
+    // In mode 1 (PV_MODE_PHASEFIX), linked channels assign bins to the
+    // spectral peaks found in channel 0 rather than each finding its
+    // own and apply channel 0's phase change at each peak to their own
+    // bins. This skips the peak search and phase estimation in channels
+    // 1 through chans - 1 and keeps the phase relationships between
+    // channels (the stereo image) intact. Channel 0 always computes its frames first, as
+    // cmupv requires, because real_run() visits channels in order and
+    // all channels request frames in lock step.
+    void set_linked(bool l) {
+        linked = l;
+        for (int i = 1; i < chans; i++) {
+            pv_set_link(states[i].pv, linked ? states[0].pv : NULL);
+        }
+    }
+
+
     void repl_input(Ugen_ptr ugen) {
         input->unref(&input);
         init_input(ugen);
@@ -8,6 +8,8 @@
 
 #include <cmath>
 #include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
 #include "recplay.h"
 
 #define INDEX_TO_BUFFER(i) ((i) / samples_per_buffer)
@@ -22,6 +24,27 @@
 
 const char *Recplay_name = "Recplay";
 
+Bufferpool recplay_pool(SAMPLES_PER_BUFFER);
+
+// Spilling to disk:
+//
+// When spill is set, the owner of the buffers (the Recplay that
+// records, not a borrower) writes every buffer except the one being
+// recorded to a temporary file using the fileio thread. Once written,
+// a buffer is "clean" and is freed when no player has needed it for
+// PAGE_EVICT_SECS. Every player (the owner or a borrower) calls
+// page_in() on the owner each block to mark the buffers from the play
+// position to PAGE_AHEAD_SECS ahead (scaled by speed) as needed and to
+// request reads of buffers that are out. When looping, the buffers at
+// the loop start are also kept in memory. If a buffer is still not in
+// memory when it is needed, the player outputs zeros (an underrun).
+// Since fileio refers to Recplay by address, we wait for fileio to
+// close the spill file before deleting the Recplay (see unref()).
+//
+#define PAGE_AHEAD_SECS 2.0
+#define PAGE_EVICT_SECS 1.0
+#define PAGE_EVICT_BLOCKS ((int) (PAGE_EVICT_SECS * BR))
+
 /******
  Computation has 5 cases:
  1. during fade at speed == 1: step through buffer and multiply by
@@ -208,10 +231,9 @@ void Recplay::real_run()
         // expand all channel storage if we need more space to record
         if (buffer >= states[0].my_buffers.size()) {
             assert(buffer == states[0].my_buffers.size());
+            add_page(buffer);
             for (int i = 0; i < chans; i++) {
-                Sample_ptr b = O2_MALLOCNT(SAMPLES_PER_BUFFER, Sample);
-                assert(b);
-                states[i].my_buffers.push_back(b);
+                states[i].my_buffers.push_back(alloc_buffer());
                 if (flags & UGENTRACE) {
                     int n = states[i].my_buffers.size();
                     if (n % 10 == 0) {
@@ -221,7 +243,11 @@ void Recplay::real_run()
                     }
                 }
             }
+        } else if (offset == 0) {  // recording over an existing buffer
+            record_into(buffer);
         }
+        rec_buffer = buffer;
+        page_used[buffer] = current_block;
         
         // record the input
         for (int i = 0; i < chans; i++) {
@@ -233,6 +259,10 @@ void Recplay::real_run()
         
     }
 
+    if (spill_open) {
+        page_out();
+    }
+
     if (playing) {
         // fade out if we are near the end. This code works on block
         // boundaries so it may fade up to one block early (<1ms)
@@ -291,15 +321,34 @@ void Recplay::real_run()
         // If offset == 0, phase can be < 0.
         double phase = play_phase - (play_index - offset);
 
+        // when spilling, the samples we need may not be in memory:
+        bool ready = true;
+        Recplay *owner = (lender_ptr ? lender_ptr : this);
+        if (owner->spill_open) {
+            owner->page_in(play_index, speed);
+            if (loop) {  // keep the loop start in memory
+                owner->page_in((long) (start_time * AR), speed);
+            }
+            ready = is_resident(play_index, last_offset);
+            if (!ready) {
+                block_zero_n(out_samps, chans);
+                if (!underrun) {
+                    arco_warn("Recplay underrun, samples not read from disk"
+                              " in time");
+                }
+            }
+            underrun = !ready;
+        }
+
         if (fading) {
             if (speed == 1.0) {
-                for (int i = 0; i < chans; i++) {
+                for (int i = 0; ready && i < chans; i++) {
                     play_fade_1(i, fade_phase, buffer, offset);
                 }
                 play_index += BL;
                 play_phase = play_index;
             } else {
-                for (int i = 0; i < chans; i++) {
+                for (int i = 0; ready && i < chans; i++) {
                     play_fade_x(i, fade_phase, buffer, offset, phase);
                 }
                 play_phase += BL * speed;
@@ -325,13 +374,13 @@ void Recplay::real_run()
             } // else we finished fading in
         } else {  // not fading
             if (speed == 1.0) {
-                for (int i = 0; i < chans; i++) {
+                for (int i = 0; ready && i < chans; i++) {
                     play_1(i, buffer, offset);
                 }
                 play_index += BL;
                 play_phase = play_index;
             } else {
-                for (int i = 0; i < chans; i++) {
+                for (int i = 0; ready && i < chans; i++) {
                     play_x(i, buffer, offset, phase);
                 }
                 play_phase += BL * speed;
@@ -347,6 +396,18 @@ void Recplay::real_run()
 }
 
 
+// get a buffer for recording, normally from recplay_pool
+Sample_ptr Recplay::alloc_buffer()
+{
+    Sample_ptr b = recplay_pool.get();
+    if (!b) {  // the main thread has not kept up, so allocate here:
+        b = O2_MALLOCNT(SAMPLES_PER_BUFFER, Sample);
+        assert(b);
+    }
+    return b;
+}
+
+
 void Recplay::record(bool record) {
     if (lender_ptr) {
         arco_warn("Recplay: can't record into lender's buffer\n");
@@ -361,6 +422,7 @@ void Recplay::record(bool record) {
     if (recording == record) {
         return;  // already recording/not recording
     }
+    reserve_buffers(record);
     if (record) {
         rec_index = 0;
         recording = true;
@@ -504,6 +566,212 @@ void Recplay::borrow(int lender_id)
 }
 
 
+void Recplay::set_spill(bool s)
+{
+    if (lender_ptr) {
+        arco_warn("Recplay::set_spill - borrower cannot spill lender's buffers");
+        return;
+    }
+    if (s && !spill_open) {
+        if (!fileio_bridge) {
+            arco_warn("Recplay::set_spill - spill requires fileio");
+            return;
+        }
+        send_spill_cmd("/fileio/spill/new", chans, samples_per_buffer, NULL);
+        spill_open = true;
+    }
+    spill = s;
+    if (!spill) {  // read everything back into memory
+        for (int b = 0; b < page_state.size(); b++) {
+            if (page_state[b] == PAGE_OUT) {
+                page_in(b * (long) samples_per_buffer, 0);
+            }
+        }
+    }
+}
+
+
+// send a message to the Fileio_spill that belongs to this Recplay.
+//     /fileio/spill/new addr chans samples_per_buffer (pass chans as
+//         chan and samples_per_buffer as buffer)
+//     /fileio/spill/write addr chan buffer samps
+//     /fileio/spill/read addr chan buffer
+//     /fileio/spill/free addr
+//
+void Recplay::send_spill_cmd(const char *address, int chan, int buffer,
+                             Sample_ptr samps)
+{
+    o2_send_start();
+    o2_add_int64((int64_t) this);
+    if (chan >= 0) {
+        o2_add_int32(chan);
+        o2_add_int32(buffer);
+    }
+    if (samps) {
+        o2_add_int64((int64_t) samps);
+    }
+    O2message_ptr msg = o2_message_finish(0.0, address, true);
+    o2_shmem_inst_outgoing_push(fileio_bridge, (O2list_elem *) msg);
+}
+
+
+// extend page tables for a newly allocated buffer
+void Recplay::add_page(int buffer)
+{
+    page_state.push_back(PAGE_DIRTY);
+    page_pending.push_back(0);
+    page_used.push_back(current_block);
+    resident.push_back(buffer);
+}
+
+
+// we are about to record from the beginning of buffer, which must
+// be in memory and will no longer match the disk copy
+void Recplay::record_into(int buffer)
+{
+    char state = page_state[buffer];
+    if (state == PAGE_OUT || state == PAGE_READING) {
+        // any samples still being read will be discarded
+        for (int i = 0; i < chans; i++) {
+            if (!states[i].my_buffers[buffer]) {
+                states[i].my_buffers[buffer] = alloc_buffer();
+            }
+        }
+        resident.push_back(buffer);
+        page_state[buffer] = PAGE_DIRTY;
+    } else if (state == PAGE_CLEAN) {
+        page_state[buffer] = PAGE_DIRTY;
+    } else if (state == PAGE_WRITING) {
+        page_state[buffer] = PAGE_REWRITE;
+    }
+}
+
+
+// a player at index with speed needs buffers from index to
+// PAGE_AHEAD_SECS ahead: mark them and read those that are out.
+// (This is called on the owner of the buffers.)
+void Recplay::page_in(long index, float speed)
+{
+    long last = index + (long) (PAGE_AHEAD_SECS * AR * MAX(speed, 1.0f));
+    int first_buffer = (int) INDEX_TO_BUFFER(index);
+    int last_buffer = MIN((int) INDEX_TO_BUFFER(last), page_state.size() - 1);
+    for (int b = first_buffer; b <= last_buffer; b++) {
+        page_used[b] = current_block;
+        if (page_state[b] == PAGE_OUT) {
+            for (int i = 0; i < chans; i++) {
+                send_spill_cmd("/fileio/spill/read", i, b, NULL);
+            }
+            page_pending[b] += chans;
+            page_state[b] = PAGE_READING;
+        }
+    }
+}
+
+
+// write dirty buffers to disk and free clean buffers that have not
+// been needed recently. To limit the work done in one block, at most
+// one buffer is written per block.
+void Recplay::page_out()
+{
+    bool written = false;
+    int i = 0;
+    while (i < resident.size()) {
+        int b = resident[i];
+        char state = page_state[b];
+        if (!spill || (recording && b == rec_buffer)) {
+            ;  // keep this buffer in memory
+        } else if (state == PAGE_DIRTY && !written) {
+            for (int ch = 0; ch < chans; ch++) {
+                send_spill_cmd("/fileio/spill/write", ch, b,
+                               states[ch].my_buffers[b]);
+            }
+            page_pending[b] += chans;
+            page_state[b] = PAGE_WRITING;
+            written = true;
+        } else if (state == PAGE_CLEAN && page_pending[b] == 0 &&
+                   current_block - page_used[b] > PAGE_EVICT_BLOCKS) {
+            for (int ch = 0; ch < chans; ch++) {
+                recplay_pool.put(states[ch].my_buffers[b]);
+                states[ch].my_buffers[b] = NULL;
+            }
+            page_state[b] = PAGE_OUT;
+            resident.remove(i);
+            continue;  // resident[i] is now a different buffer
+        }
+        i++;
+    }
+}
+
+
+// test if all samples from first to last are in memory for all channels
+bool Recplay::is_resident(long first, long last)
+{
+    int last_buffer = (int) INDEX_TO_BUFFER(last);
+    for (int b = (int) INDEX_TO_BUFFER(first); b <= last_buffer; b++) {
+        for (int i = 0; i < chans; i++) {
+            Vec<Sample_ptr> &buffers = *states[i].buffers;
+            if (b >= buffers.size() || !buffers[b]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+// update page state when all reads and writes of buffer are finished
+void Recplay::io_done(int buffer)
+{
+    char state = page_state[buffer];
+    if (state == PAGE_READING) {
+        page_state[buffer] = PAGE_CLEAN;
+        resident.push_back(buffer);
+    } else if (state == PAGE_WRITING) {
+        page_state[buffer] = PAGE_CLEAN;
+    } else if (state == PAGE_REWRITE) {
+        page_state[buffer] = PAGE_DIRTY;
+    }
+}
+
+
+void Recplay::spill_written(int chan, int buffer, bool ok)
+{
+    if (!ok) {
+        if (spill) {
+            arco_warn("Recplay: failed to write spill file, spill disabled");
+        }
+        spill = false;
+        page_state[buffer] = PAGE_REWRITE;  // becomes PAGE_DIRTY
+    }
+    if (--page_pending[buffer] == 0) {
+        io_done(buffer);
+    }
+}
+
+
+void Recplay::spill_paged(int chan, int buffer, Sample_ptr samps)
+{
+    if (page_state[buffer] == PAGE_READING) {
+        states[chan].my_buffers[buffer] = samps;
+    } else {  // recorded over while reading, so samps are not needed
+        recplay_pool.put(samps);
+    }
+    if (--page_pending[buffer] == 0) {
+        io_done(buffer);
+    }
+}
+
+
+// fileio has closed the spill file, so there will be no more messages
+// addressed to this Recplay and it can finally be deleted
+void Recplay::spill_closed()
+{
+    spill_open = false;
+    Ugen *ugen = this;
+    unref(&ugen);
+}
+
+
 /* O2SM INTERFACE: /arco/recplay/new int32 id, int32 chans, 
               int32 input_id, int32 gain_id, float fade, bool loop;
  */
@@ -638,6 +906,67 @@ static void arco_replay_borrow(O2SM_HANDLER_ARGS)
 }
 
 
+/* O2SM INTERFACE: /arco/recplay/spill int32 id, bool spill;
+ */
+static void arco_recplay_spill(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    bool spill = argv[1]->B;
+    // end unpack message
+
+    UGEN_FROM_ID(Recplay, recplay, id, "arco_recplay_spill");
+    recplay->set_spill(spill);
+}
+
+
+/* O2SM INTERFACE: /arco/recplay/written
+       int64 addr, int32 chan, int32 buffer, bool ok;
+   Reply from fileio: buffer for chan is written to the spill file.
+ */
+static void arco_recplay_written(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    int32_t chan = argv[1]->i;
+    int32_t buffer = argv[2]->i;
+    bool ok = argv[3]->B;
+    // end unpack message
+
+    ((Recplay *) addr)->spill_written(chan, buffer, ok);
+}
+
+
+/* O2SM INTERFACE: /arco/recplay/paged
+       int64 addr, int32 chan, int32 buffer, int64 samps;
+   Reply from fileio: samps is buffer for chan read from the spill file.
+ */
+static void arco_recplay_paged(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    int32_t chan = argv[1]->i;
+    int32_t buffer = argv[2]->i;
+    int64_t samps = argv[3]->h;
+    // end unpack message
+
+    ((Recplay *) addr)->spill_paged(chan, buffer, (Sample_ptr) samps);
+}
+
+
+/* O2SM INTERFACE: /arco/recplay/unspilled int64 addr;
+   Reply from fileio: the spill file is closed.
+ */
+static void arco_recplay_unspilled(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int64_t addr = argv[0]->h;
+    // end unpack message
+
+    ((Recplay *) addr)->spill_closed();
+}
+
+
 static void recplay_init()
 {
     // O2SM INTERFACE INITIALIZATION: (machine generated)
@@ -659,6 +988,14 @@ static void recplay_init()
                     true);
     o2sm_method_new("/arco/recplay/borrow", "ii", arco_replay_borrow, NULL,
                     true, true);
+    o2sm_method_new("/arco/recplay/spill", "iB", arco_recplay_spill, NULL,
+                    true, true);
+    o2sm_method_new("/arco/recplay/written", "hiiB", arco_recplay_written,
+                    NULL, true, true);
+    o2sm_method_new("/arco/recplay/paged", "hiih", arco_recplay_paged, NULL,
+                    true, true);
+    o2sm_method_new("/arco/recplay/unspilled", "h", arco_recplay_unspilled,
+                    NULL, true, true);
     // END INTERFACE INITIALIZATION
 }
 
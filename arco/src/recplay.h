@@ -27,6 +27,11 @@
 // recording is stored in a dynamic array of buffers. Each buffer
 // holds 32K samples or about 0.7s of mono. Samples are stored in
 // blocks of size BL. This allows us to transfer one block at a time.
+//
+// With spill (see set_spill), buffers that are no longer needed are
+// written to a temporary file by the fileio thread and freed, and
+// buffers are read back in ahead of the play position, so memory use
+// is bounded while recording length is limited only by disk space.
 
 #define LOG2_BLOCKS_PER_BUFFER 10
 #define LOG2_SAMPLES_PER_BUFFER (LOG2_BLOCKS_PER_BUFFER + LOG2_BL)
@@ -46,6 +51,21 @@
 
 #include <climits>
 
+// page states for spilling buffers to disk:
+const char PAGE_DIRTY = 0;    // in memory only (or disk copy is stale)
+const char PAGE_WRITING = 1;  // in memory, write to disk in progress
+const char PAGE_REWRITE = 2;  // like PAGE_WRITING, but modified since
+const char PAGE_CLEAN = 3;    // in memory and on disk
+const char PAGE_OUT = 4;      // on disk only
+const char PAGE_READING = 5;  // read from disk in progress
+
+extern void *fileio_bridge;
+
+// Recording buffers come from recplay_pool so that recording does not
+// call the allocator (see bufferpool.h). While recording, each Recplay
+// reserves RECPLAY_POOL_RESERVE buffers per channel:
+#define RECPLAY_POOL_RESERVE 2
+extern Bufferpool recplay_pool;
 
 
 extern const char *Recplay_name;
@@ -98,6 +118,19 @@ public:
     // of samples we will use -- it is greater or equal to SAMPLES_PER_BUFFER
     // and also a multiple of BLOCK_BYTES so we can transfer a block at at time:
     int samples_per_buffer;
+
+    // Spilling to disk: page state is kept by the owner of my_buffers
+    // and shared with borrowers, who call page_in() on the owner:
+    bool spill;          // write old buffers to disk and free them
+    bool spill_open;     // fileio has a spill file for us
+    bool spill_closing;  // waiting for fileio to close the spill file
+    bool underrun;       // a needed buffer was not paged in in time
+    int rec_buffer;      // the buffer we are recording into
+    bool pool_reserved;  // we have reserved buffers in recplay_pool
+    Vec<char> page_state;     // for each buffer: PAGE_DIRTY, etc.
+    Vec<short> page_pending;  // for each buffer: outstanding reads/writes
+    Vec<int> page_used;       // for each buffer: block when last needed
+    Vec<int> resident;        // indices of buffers in memory
         
     Ugen_ptr input;
     int input_stride;
@@ -124,6 +157,12 @@ public:
         playing = false;
         fading = false;
         stopping = false;
+        spill = false;
+        spill_open = false;
+        spill_closing = false;
+        underrun = false;
+        rec_buffer = 0;
+        pool_reserved = false;
         states.set_size(chans);
 
         for (int i = 0; i < chans; i++) {
@@ -148,6 +187,7 @@ public:
         int i;
         input->unref(&input);
         gain->unref(&gain);
+        reserve_buffers(false);
         if (loan_count) {
             arco_error("Recplay::~Recplay -- loan_count non-zero!");
             return;
@@ -158,11 +198,32 @@ public:
         for (int chan = 0; chan < chans; chan++) {
             Vec<Sample_ptr> &buffers = states[chan].my_buffers;
             for (int i = 0; i < buffers.size(); i++) {
-                O2_FREE(buffers[i]);
+                if (buffers[i]) {  // spilled buffers are NULL
+                    recplay_pool.put(buffers[i]);  // main thread will free
+                }
             }
             buffers.finish();
         }
         states.finish();
+        page_state.finish();
+        page_pending.finish();
+        page_used.finish();
+        resident.finish();
+    }
+
+
+    // when we spill to disk, fileio can send messages to this Recplay
+    // by address, so we cannot be deleted until fileio confirms that
+    // the spill file is closed (see spill_closed()):
+    void unref(Ugen **ptr) {
+        if (refcount == 1 && spill_open) {
+            if (!spill_closing) {
+                spill_closing = true;
+                send_spill_cmd("/fileio/spill/free", -1, -1, NULL);
+            }
+            return;
+        }
+        Ugen::unref(ptr);
     }
 
     const char *classname() { return Recplay_name; }
@@ -184,9 +245,9 @@ public:
 
 
     void print_details(int indent) {
-        arco_print("rec %s, play %s speed %g",
+        arco_print("rec %s, play %s speed %g spill %s resident %d/%d",
                    recording ? "true" : "false", playing ? "true" : "false",
-                   speed);
+                   speed, btos(spill), resident.size(), page_state.size());
     }
 
 
@@ -218,6 +279,16 @@ public:
         assert(ugen->rate != 'a');  // allow 'c' and (non-interpolated) 'b'
         init_param(ugen, gain, &gain_stride);  }
 
+    void reserve_buffers(bool reserve) {
+        if (reserve != pool_reserved) {
+            int n = chans * RECPLAY_POOL_RESERVE;
+            recplay_pool.reserve(reserve ? n : -n);
+            pool_reserved = reserve;
+        }
+    }
+
+    Sample_ptr alloc_buffer();
+
     void record(bool record);
 
     void start(double start_time);
@@ -226,6 +297,29 @@ public:
 
     void borrow(int lender_id);
 
+    void set_spill(bool s);
+
+    void send_spill_cmd(const char *address, int chan, int buffer,
+                        Sample_ptr samps);
+
+    void add_page(int buffer);
+
+    void record_into(int buffer);
+
+    void page_in(long index, float speed);
+
+    void page_out();
+
+    bool is_resident(long first, long last);
+
+    void io_done(int buffer);
+
+    void spill_written(int chan, int buffer, bool ok);
+
+    void spill_paged(int chan, int buffer, Sample_ptr samps);
+
+    void spill_closed();
+
     void play_fade_1(int chan, float fade_phase, int buffer, int offset);
 
     void play_fade_x(int chan, float fade_phase, int buffer, int offset,
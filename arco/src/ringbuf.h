@@ -58,10 +58,12 @@ class Ringbuf : public Vec<Sample> {
     }
 
     
-    void enqueue_block(Sample *block) {
-        for (int i = 0; i < BL; i++) {
-            enqueue(block[i]);
-        }
+    // The block operations below copy n samples with memcpy, split in
+    // two at most once where the span wraps around the end of array.
+
+    void enqueue_block(const Sample *block, int n = BL) {
+        copy_in(tail, block, n);
+        tail = (tail + n) & mask;
     }
 
     
@@ -78,9 +80,50 @@ class Ringbuf : public Vec<Sample> {
     }
     
     
-    void dequeue_block(Sample *block) {
-        for (int i = 0; i < BL; i++) {
-            block[i] = dequeue();
+    void dequeue_block(Sample *block, int n = BL) {
+        copy_out(block, head, n);
+        head = (head + n) & mask;
+    }
+
+
+    void read_nth(Sample *block, int n, int count = BL) {
+    // copy count samples starting at get_nth(n) to block, i.e. block[i]
+    // = get_nth(n - i). The queue is not changed. In a delay line of
+    // length at least BL, these are the samples that get_nth(n) would
+    // return while the next BL samples are enqueued one at a time.
+        copy_out(block, (tail - n) & mask, count);
+    }
+
+
+    void add_to_last(const Sample *block, int n = BL) {
+    // add block to the n most recently enqueued samples, i.e. block[i]
+    // is added with add_to_nth(block[i], n - i).
+        int start = (tail - n) & mask;
+        int n1 = MIN(n, length - start);
+        Sample *dst = array + start;
+        for (int i = 0; i < n1; i++) {
+            dst[i] += block[i];
+        }
+        for (int i = n1; i < n; i++) {
+            array[i - n1] += block[i];
+        }
+    }
+
+
+    void copy_in(int start, const Sample *src, int n) {
+        int n1 = MIN(n, length - start);
+        memcpy(array + start, src, n1 * sizeof(Sample));
+        if (n1 < n) {
+            memcpy(array, src + n1, (n - n1) * sizeof(Sample));
+        }
+    }
+
+
+    void copy_out(Sample *dst, int start, int n) {
+        int n1 = MIN(n, length - start);
+        memcpy(dst, array + start, n1 * sizeof(Sample));
+        if (n1 < n) {
+            memcpy(dst + n1, array, (n - n1) * sizeof(Sample));
         }
     }
 
@@ -117,6 +160,36 @@ class Ringbuf : public Vec<Sample> {
             set_size(vec_len(len));
             mask = size() - 1;
         }
+        rearrange(old_len, fifo_len, len, longer);
+    }
+
+
+    Sample *set_fifo_len(int len, bool longer, Sample *storage, int n) {
+    // like set_fifo_len(len, longer), but rather than reallocating,
+    // move into storage, which has room for n samples (n must be a
+    // power of 2 > len). The old storage is returned to the caller,
+    // who is responsible for freeing it. This lets the audio thread
+    // grow a buffer using memory allocated elsewhere (see bufferpool.h).
+        assert(n > len && (n & (n - 1)) == 0 && n >= length);
+        int old_len = length;
+        int fifo_len = get_fifo_len();
+        Sample *old = array;
+        if (old_len > 0) {
+            memcpy(storage, array, old_len * sizeof(Sample));
+        }
+        array = storage;
+        allocated = n;
+        length = n;
+        mask = n - 1;
+        rearrange(old_len, fifo_len, len, longer);
+        return old;
+    }
+
+
+    void rearrange(int old_len, int fifo_len, int len, bool longer) {
+    // after growing from old_len to length, move data so that the
+    // queue is contiguous again and, if longer, insert zeros (see
+    // set_fifo_len()).
         int n = length - old_len;  // how much did we grow?
         if (len > fifo_len) {
             // now queue looks like [tuvwxT...Hpqrs?????], where Hpqrs is
@@ -127,11 +200,11 @@ class Ringbuf : public Vec<Sample> {
             // First, if head > tail, move Hpqrs to the end of new vec.array:
             if (head > tail) {
                 Sample *headptr = array + head;
-                int to_end = fifo_len - head;
-                memmove(headptr, headptr + n, to_end * sizeof(Sample));
+                int to_end = old_len - head;
+                memmove(headptr + n, headptr, to_end * sizeof(Sample));
                 // check: we want headptr + n + to_end == array + length
                 // => array + head + n + to_end == array + length
-                // => head + length - fifo_len + fifo_len - head = length
+                // => head + length - old_len + old_len - head = length
                 // => length = length, so we moved data to the end of array
                 head += n;
             }
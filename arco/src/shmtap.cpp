@@ -0,0 +1,235 @@
+/* shmtap.cpp -- write signals to a shared memory ring for local clients
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#ifdef WIN32
+#define WIN32_LEAN_AND_MEAN 1
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "arcougen.h"
+#include "o2atomic.h"
+#include "offload.h"
+#include "shmtap.h"
+
+const char *Shmtap_name = "Shmtap";
+
+
+// create and initialize the ring on the main thread (see offload.h)
+class Shmtap_map_job : public Offload_job {
+  public:
+    Shmtap *owner;
+    char *name;
+    size_t size;
+    int chans;
+    int frames;
+    Shmtap_ring *ring;  // result of run()
+    void *handle;
+
+    Shmtap_map_job(Shmtap *owner_) {
+        owner = owner_;
+        owner->ref();  // do not delete owner until finish()
+        name = owner->shm_name;  // owner, so name, outlives the job
+        size = owner->shm_size;
+        chans = owner->chans;
+        frames = owner->frames;
+        ring = NULL;
+        handle = NULL;
+    }
+
+    void run() {
+        void *mem = NULL;
+#ifdef WIN32
+        HANDLE h = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL,
+                                      PAGE_READWRITE, 0, (DWORD) size,
+                                      name + 1);  // no "/" on Windows
+        if (h) {
+            mem = MapViewOfFile(h, FILE_MAP_ALL_ACCESS, 0, 0, size);
+            if (mem) {
+                handle = h;
+            } else {
+                CloseHandle(h);
+            }
+        }
+#else
+        int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+        if (fd >= 0) {
+            if (ftruncate(fd, size) == 0) {
+                mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                           fd, 0);
+                if (mem == MAP_FAILED) {
+                    mem = NULL;
+                }
+            }
+            close(fd);
+            if (!mem) {  // do not leave an unusable object behind
+                shm_unlink(name);
+            }
+        }
+#endif
+        if (!mem) {
+            return;
+        }
+        memset(mem, 0, size);
+        ring = (Shmtap_ring *) mem;
+        ring->version = SHMTAP_VERSION;
+        ring->chans = chans;
+        ring->frames = frames;
+        ring->sample_rate = AR;
+        ring->header_size = sizeof(Shmtap_ring);
+        ring->write_count.store(0);
+        // readers test magic to see that the header is complete:
+        std::atomic_thread_fence(std::memory_order_release);
+        ring->magic = SHMTAP_MAGIC;
+    }
+
+    void finish() {
+        if (ring) {
+            owner->install(ring, handle);
+        } else {
+            arco_warn("Shmtap %d: could not create shared memory %s",
+                      owner->id, name);
+        }
+        owner->unref((Ugen **) &owner);
+    }
+};
+
+
+// remove the ring on the main thread
+class Shmtap_unmap_job : public Offload_job {
+  public:
+    char *name;
+    size_t size;
+    Shmtap_ring *ring;
+    void *handle;
+
+    Shmtap_unmap_job(char *name_, size_t size_, Shmtap_ring *ring_,
+                     void *handle_) {
+        name = name_;  // the job now owns name
+        size = size_;
+        ring = ring_;
+        handle = handle_;
+    }
+
+    ~Shmtap_unmap_job() {
+        O2_FREE(name);
+    }
+
+    void run() {
+        if (!ring) {
+            return;
+        }
+#ifdef WIN32
+        UnmapViewOfFile(ring);
+        CloseHandle((HANDLE) handle);
+#else
+        munmap(ring, size);
+        shm_unlink(name);
+#endif
+    }
+
+    void finish() { }
+};
+
+
+Shmtap::Shmtap(int id, int nchans, Ugen_ptr input_, int first_,
+               int frames_, const char *name) : Ugen(id, 0, MAX(nchans, 1))
+{
+    ring = NULL;
+    samples = NULL;
+    map_handle = NULL;
+    first = MAX(first_, 0);
+    frames = 2 * BL;
+    while (frames < frames_) frames <<= 1;
+    mask = frames - 1;
+    write_count = 0;
+    shm_size = sizeof(Shmtap_ring) + (size_t) chans * frames * sizeof(Sample);
+    int len = (int) strlen(name);
+    shm_name = O2_MALLOCNT(len + 2, char);
+    shm_name[0] = '/';
+    strcpy(shm_name + 1, name + (name[0] == '/'));
+    init_param(input_, input, &input_stride);
+    offload(new Shmtap_map_job(this));
+}
+
+
+Shmtap::~Shmtap()
+{
+    input->unref(&input);
+    offload(new Shmtap_unmap_job(shm_name, shm_size, ring, map_handle));
+}
+
+
+void Shmtap::real_run()
+{
+    if (!ring) {
+        return;  // not mapped yet
+    }
+    input_samps = input->run(current_block);
+    int n = (input->rate == 'a' ? BL : 1);
+    int pos = (int) (write_count & mask);
+    int n1 = MIN(n, frames - pos);  // frames before wrapping
+    for (int c = 0; c < chans; c++) {
+        int ic = MIN(first + c, input->chans - 1);
+        Sample_ptr src = input_samps + ic * input_stride;
+        Sample *dst = samples + c * frames;
+        memcpy(dst + pos, src, n1 * sizeof(Sample));
+        if (n1 < n) {
+            memcpy(dst, src + n1, (n - n1) * sizeof(Sample));
+        }
+    }
+    write_count += n;
+    ring->write_count.store(write_count, std::memory_order_release);
+}
+
+
+/* O2SM INTERFACE: /arco/shmtap/new int32 id, int32 chans, int32 input,
+       int32 first, int32 frames, string name;
+ */
+static void arco_shmtap_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chans = argv[1]->i;
+    int32_t input = argv[2]->i;
+    int32_t first = argv[3]->i;
+    int32_t frames = argv[4]->i;
+    char *name = argv[5]->s;
+    // end unpack message
+
+    ANY_UGEN_FROM_ID(input_ugen, input, "arco_shmtap_new");
+    new Shmtap(id, chans, input_ugen, first, frames, name);
+}
+
+
+/* O2SM INTERFACE: /arco/shmtap/repl_input int32 id, int32 input_id;
+ */
+static void arco_shmtap_repl_input(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t input_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Shmtap, shmtap, id, "arco_shmtap_repl_input");
+    ANY_UGEN_FROM_ID(input, input_id, "arco_shmtap_repl_input");
+    shmtap->repl_input(input);
+}
+
+
+static void shmtap_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/shmtap/new", "iiiiis", arco_shmtap_new, NULL,
+                    true, true);
+    o2sm_method_new("/arco/shmtap/repl_input", "ii", arco_shmtap_repl_input,
+                    NULL, true, true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer shmtap_init_obj(shmtap_init);
@@ -0,0 +1,129 @@
+/* shmtap.h -- write signals to a shared memory ring for local clients
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Shmtap copies chans channels of its input, starting at channel
+ * first, into a ring buffer in named shared memory. Local processes
+ * (scopes, spectrum displays, meters) map the ring and read the most
+ * recent samples whenever they redraw, so there are no O2 messages at
+ * all, where Probe needs ceiling(frames * chans / 64) messages per
+ * snapshot.
+ *
+ * The ring is a Shmtap_ring header followed by chans arrays of frames
+ * floats (channel 0 first). frames is a power of 2, so frame n of
+ * channel c is at samples[c * frames + (n & (frames - 1))]. There is
+ * one writer, the audio thread, which copies each block and then
+ * stores write_count (total frames written) with release ordering.
+ * Readers never write, so there can be any number of them and the
+ * audio thread never waits. The writer does not wait for readers
+ * either: old frames are overwritten. To read the last n frames:
+ *     w1 = write_count (acquire), copy frames w1 - n to w1 - 1,
+ *     w2 = write_count; the copy is valid if w2 - (w1 - n) <= frames.
+ * Input may be audio rate (BL frames per block) or block rate (1 frame
+ * per block); sample_rate gives the frame rate.
+ *
+ * Creating and removing shared memory are system calls, so they run
+ * on the main thread (see offload.h). Frames are not written until the
+ * ring is mapped. The name is a POSIX shared memory name ("/name";
+ * a leading "/" is added if missing) or, on Windows, a file mapping
+ * name (without the "/"). This matches Python's
+ * multiprocessing.shared_memory.SharedMemory(name) on both systems.
+ * The ring is removed when the Shmtap is freed, but clients that have
+ * it mapped can keep reading (frozen) frames until they unmap it.
+ */
+
+#ifndef SHMTAP_H
+#define SHMTAP_H
+
+#include <atomic>
+
+#define SHMTAP_MAGIC 0x41524354  // "ARCT", set when the ring is ready
+#define SHMTAP_VERSION 1
+
+struct Shmtap_ring {
+    uint32_t magic;
+    uint32_t version;
+    int32_t chans;
+    int32_t frames;      // capacity in frames, a power of 2
+    float sample_rate;   // frames per second
+    int32_t header_size; // byte offset of the samples, sizeof(Shmtap_ring)
+    std::atomic<uint64_t> write_count;  // frames written so far
+    char pad[32];        // samples start on a cache line
+};
+
+static_assert(sizeof(Shmtap_ring) == 64, "Shmtap_ring must be 64 bytes");
+
+extern const char *Shmtap_name;
+
+class Shmtap : public Ugen {
+public:
+    Shmtap_ring *ring;     // NULL until mapped
+    Sample *samples;       // samples in ring
+    void *map_handle;      // for unmapping (Windows only)
+    char *shm_name;
+    size_t shm_size;
+    int first;             // first input channel to copy
+    int frames;
+    int mask;
+    uint64_t write_count;  // local copy of ring->write_count
+
+    Ugen_ptr input;
+    int input_stride;
+    Sample_ptr input_samps;
+
+    // output rate is 0 because there is no output. chans is the number
+    // of channels to copy to the ring.
+    Shmtap(int id, int nchans, Ugen_ptr input_, int first_, int frames_,
+           const char *name);
+
+    ~Shmtap();
+
+    const char *classname() { return Shmtap_name; }
+
+#if ARCO_REF_DEBUG
+    // for tracing tree of Ugens. Returns true with the ith child in *child
+    // or false if i is too high.
+    bool get_ref(int i, Ugen **child) {
+        // 1 input
+        if (i == 0) { *child = input; return true; }
+        return false;
+    }
+#endif
+
+    void print_details(int indent) {
+        arco_print("name %s first %d frames %d mapped %s", shm_name,
+                   first, frames, ring ? "true" : "false");
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        input->print_tree(indent, print_flag, "input");
+    }
+
+    void repl_input(Ugen_ptr ugen) {
+        input->unref(&input);
+        init_input(ugen);
+    }
+
+    void init_input(Ugen_ptr ugen) {
+        init_param(ugen, input, &input_stride);
+        if (ring) {
+            ring->sample_rate = (input->rate == 'a' ? AR : BR);
+        }
+    }
+
+    // called when the main thread has mapped the ring (or failed)
+    void install(Shmtap_ring *ring_, void *map_handle_) {
+        ring = ring_;
+        map_handle = map_handle_;
+        if (ring) {
+            samples = (Sample *) (ring + 1);
+            ring->sample_rate = (input->rate == 'a' ? AR : BR);
+        }
+    }
+
+    void real_run();
+};
+
+#endif
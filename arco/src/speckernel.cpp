@@ -0,0 +1,136 @@
+/* speckernel.cpp -- weighted sums of a magnitude spectrum
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include <cmath>
+#include "arcougen.h"
+#include "speckernel.h"
+
+// critical band edges in Hz (Zwicker, 1961); band i is from edge i to
+// edge i + 1:
+static const double bark_edges[] = {
+        0, 100, 200, 300, 400, 510, 630, 770, 920, 1080, 1270, 1480,
+        1720, 2000, 2320, 2700, 3150, 3700, 4400, 5300, 6400, 7700,
+        9500, 12000, 15500 };
+#define NUM_BARK_EDGES ((int) (sizeof(bark_edges) / sizeof(bark_edges[0])))
+
+
+static double hz_to_mel(double hz)
+{
+    return 2595.0 * log10(1.0 + hz / 700.0);
+}
+
+
+static double mel_to_hz(double mel)
+{
+    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+}
+
+
+int Speckernel::add_row(int first_bin, int n, const float *w)
+{
+    if (first_bin < 0) {  // drop weights below bin 0
+        if (w) w -= first_bin;
+        n += first_bin;
+        first_bin = 0;
+    }
+    n = MAX(MIN(n, num_bins - first_bin), 0);
+    Row row;
+    row.first_bin = first_bin;
+    row.length = n;
+    row.offset = weights.size();
+    float *dst = weights.append_space(n);
+    if (w) {
+        memcpy(dst, w, n * sizeof(float));
+    } else {  // caller will fill in the weights
+        memset(dst, 0, n * sizeof(float));
+    }
+    rows.push_back(row);
+    return rows.size() - 1;
+}
+
+
+int Speckernel::add_moment(double bin_hz, int power)
+{
+    int r = add_row(0, num_bins, NULL);
+    float *w = &weights[rows[r].offset];
+    for (int k = 0; k < num_bins; k++) {
+        w[k] = (float) pow(k * bin_hz, power);
+    }
+    return r;
+}
+
+
+int Speckernel::add_mel_bands(int n, double lo_hz, double hi_hz,
+                              double bin_hz)
+{
+    int first_row = rows.size();
+    double lo_mel = hz_to_mel(lo_hz);
+    double mel_step = (hz_to_mel(hi_hz) - lo_mel) / (n + 1);
+    for (int b = 0; b < n; b++) {
+        double lower = mel_to_hz(lo_mel + b * mel_step);
+        double center = mel_to_hz(lo_mel + (b + 1) * mel_step);
+        double upper = mel_to_hz(lo_mel + (b + 2) * mel_step);
+        int first_bin = (int) floor(lower / bin_hz) + 1;
+        int last_bin = (int) ceil(upper / bin_hz) - 1;
+        int r = add_row(first_bin, last_bin - first_bin + 1, NULL);
+        Row &row = rows[r];
+        float *w = &weights[row.offset];
+        for (int i = 0; i < row.length; i++) {
+            double hz = (row.first_bin + i) * bin_hz;
+            w[i] = (float) (hz < center ? (hz - lower) / (center - lower) :
+                                          (upper - hz) / (upper - center));
+            w[i] = MAX(w[i], 0.0f);
+        }
+    }
+    return first_row;
+}
+
+
+int Speckernel::add_bark_bands(double bin_hz)
+{
+    int first_row = rows.size();
+    double nyquist = (num_bins - 1) * bin_hz;
+    for (int b = 0; b < NUM_BARK_EDGES - 1; b++) {
+        if (bark_edges[b + 1] > nyquist) {
+            break;
+        }
+        int first_bin = (int) ceil(bark_edges[b] / bin_hz);
+        int end_bin = (int) ceil(bark_edges[b + 1] / bin_hz);
+        int r = add_row(first_bin, end_bin - first_bin, NULL);
+        Row &row = rows[r];
+        float *w = &weights[row.offset];
+        for (int i = 0; i < row.length; i++) {
+            w[i] = 1.0f;
+        }
+    }
+    return first_row;
+}
+
+
+void Speckernel::apply(const float *spectrum, float *out)
+{
+    const int L = SPECKERNEL_LANES;
+    for (int r = 0; r < rows.size(); r++) {
+        const Row &row = rows[r];
+        const float *x = spectrum + row.first_bin;
+        const float *w = weights.get_array() + row.offset;
+        int n = row.length - row.length % L;
+        float sums[L] = { 0 };
+        for (int i = 0; i < n; i += L) {
+            for (int j = 0; j < L; j++) {
+                sums[j] += w[i + j] * x[i + j];
+            }
+        }
+        float sum = 0;
+        for (int j = 0; j < L; j++) {
+            sum += sums[j];
+        }
+        for (int i = n; i < row.length; i++) {
+            sum += w[i] * x[i];
+        }
+        out[r] = sum;
+    }
+}
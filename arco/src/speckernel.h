@@ -0,0 +1,74 @@
+/* speckernel.h -- weighted sums of a magnitude spectrum
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* A Speckernel is a precomputed weight matrix that turns a magnitude
+ * spectrum (num_bins values) into features: kernel.apply(spectrum, out)
+ * computes out[r] = sum over bins k of weight[r][k] * spectrum[k] for
+ * each row r. Rows are stored sparsely as a run of contiguous bins, so
+ * a band costs only its width, while a moment (all bins) is a dense
+ * row. Spectral centroid is the ratio of two moments; mel and bark band
+ * energies are sets of bands. A new spectral feature can be computed by
+ * adding rows rather than writing another loop over bins.
+ *
+ * Rows are built once with the add_ methods (which allocate), then
+ * apply() runs in the audio thread without allocation. apply() keeps
+ * SPECKERNEL_LANES partial sums per row so that it vectorizes.
+ *
+ * bin_hz, the frequency spacing of bins, is the sample rate divided by
+ * the FFT size; bin k is at frequency k * bin_hz.
+ */
+
+#ifndef __Speckernel_H__
+#define __Speckernel_H__
+
+#define SPECKERNEL_LANES 8  // partial sums per row in apply()
+
+class Speckernel {
+  public:
+    struct Row {
+        int first_bin;  // the row has weights for first_bin ...
+        int length;     //     first_bin + length - 1
+        int offset;     // index of the first weight in weights
+    };
+
+    int num_bins;
+    Vec<Row> rows;
+    Vec<float> weights;  // weights of all rows, concatenated
+
+    Speckernel(int num_bins_) { num_bins = num_bins_; }
+
+    int size() { return rows.size(); }
+
+    void clear() {
+        rows.clear();
+        weights.clear();
+    }
+
+    // add a row with n weights starting at first_bin (zeros if w is
+    // NULL); bins outside of the spectrum are dropped. Returns the row
+    // index.
+    int add_row(int first_bin, int n, const float *w);
+
+    // add a row of frequency^power for all bins; power 0 sums the
+    // spectrum. Returns the row index.
+    int add_moment(double bin_hz, int power);
+
+    // add n triangular mel bands evenly spaced in mel from lo_hz to
+    // hi_hz, where each band rises from the center of the previous band
+    // to a peak of 1 at its center and falls to the center of the next.
+    // Returns the index of the first row.
+    int add_mel_bands(int n, double lo_hz, double hi_hz, double bin_hz);
+
+    // add rectangular bark (critical) bands with Zwicker's edges, up to
+    // the highest band below the Nyquist frequency. Returns the index of
+    // the first row; size() tells how many were added.
+    int add_bark_bands(double bin_hz);
+
+    // compute all rows: out[r] for r in 0 .. size() - 1
+    void apply(const float *spectrum, float *out);
+};
+
+#endif
@@ -15,21 +15,20 @@ void SpectralCentroid::real_run()
 
     if (fftcalc.isReady()) { // only runs if we have enough samples
         float* magnSpec = fftcalc.getMagnitudeSpectrum();
-        float* FFTFreqs = fftcalc.getFFTFrequencies();
-        
-        float sum = 0.0f, weightedSum = 0.0f;
-        
-        for (int i = 0; i < fftcalc.bufferSize / 2 + 1; i ++) {
-            sum += magnSpec[i];
-            weightedSum += magnSpec[i] * FFTFreqs[i];
-        }
+        float moments[2];
+        kernel.apply(magnSpec, moments);
+        float sum = moments[0], weightedSum = moments[1];
         
         // Spectral centroid = weightedSum / sum
         float result = (sum != 0.0f) ? (weightedSum / sum) : 0.0f;
         
-        o2sm_send_start();
-        o2sm_add_float(result);
-        o2sm_send_finish(0, cd_reply_addr, false);
+        feature = result;
+        feature_frames++;
+        if (cd_reply_addr[0]) {
+            o2sm_send_start();
+            o2sm_add_float(result);
+            o2sm_send_finish(0, cd_reply_addr, false);
+        }
     }
     
 }
@@ -7,21 +7,31 @@
 #define __spectralcentroid_H__
 
 #include "FFTCalculator.h"
+#include "speckernel.h"
 
 extern const char *SpectralCentroid_name;
 
 class SpectralCentroid : public Ugen {
 public:
     char *cd_reply_addr; // Reply address for O2
+    Sample feature;      // latest result (see get_features())
+    int feature_frames;
     
     Ugen_ptr input;
     int input_stride;
     Sample_ptr input_samps;
     FFTCalculator fftcalc;
+    Speckernel kernel;  // row 0: sum of magnitudes, 1: sum of freq * mag
     
     SpectralCentroid(int id, Ugen_ptr input, char *reply_addr) :
-            Ugen(id, 0, 0), fftcalc(BL, AR) {
+            Ugen(id, 0, 0), fftcalc(BL, AR),
+            kernel(fftcalc.bufferSize / 2 + 1) {
         cd_reply_addr = NULL;
+        double bin_hz = AR / fftcalc.bufferSize;
+        kernel.add_moment(bin_hz, 0);
+        kernel.add_moment(bin_hz, 1);
+        feature = 0;
+        feature_frames = 0;
         init_input(input);
         start(reply_addr);
     }
@@ -77,6 +87,12 @@ public:
 
     void start(const char *reply_addr);
 
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = &feature;
+        *frame_count = feature_frames;
+        return 1;
+    }
+
     void real_run();
 };
 
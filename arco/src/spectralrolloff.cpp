@@ -37,9 +37,13 @@ void SpectralRolloff::real_run()
         
         float result = FFTFreqs[rolloffBin];
         
-        o2sm_send_start();
-        o2sm_add_float(result);
-        o2sm_send_finish(0, cd_reply_addr, false);
+        feature = result;
+        feature_frames++;
+        if (cd_reply_addr[0]) {
+            o2sm_send_start();
+            o2sm_add_float(result);
+            o2sm_send_finish(0, cd_reply_addr, false);
+        }
     }
 }
 
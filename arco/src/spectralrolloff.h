@@ -13,6 +13,8 @@ extern const char *SpectralRolloff_name;
 class SpectralRolloff : public Ugen {
 public:
     char *cd_reply_addr; // Reply address for O2
+    Sample feature;      // latest result (see get_features())
+    int feature_frames;
     
     Ugen_ptr input;
     int input_stride;
@@ -25,6 +27,8 @@ public:
                     float threshold = 0.85) :
             Ugen(id, 0, 0), fftcalc(BL, AR), threshold(threshold) {
         cd_reply_addr = NULL;
+        feature = 0;
+        feature_frames = 0;
         init_input(input);
         start(reply_addr);
     }
@@ -80,6 +84,12 @@ public:
 
     void start(const char *reply_addr);
 
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = &feature;
+        *frame_count = feature_frames;
+        return 1;
+    }
+
     void real_run();
 };
 
@@ -5,6 +5,9 @@
  */
 
 #include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
+#include "offload.h"
 #include "wavetables.h"
 #include "tableosc.h"
 
@@ -140,6 +143,18 @@ void arco_tableosc_borrow(O2SM_HANDLER_ARGS)
     }
 }
 
+/* O2SM INTERFACE: /arco/tableosc/bank int32 id;
+ */
+void arco_tableosc_bank(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Tableosc, tableosc, id, "arco_tableosc_bank");
+    tableosc->borrow(wavetable_bank());
+}
+
 void arco_tableosc_createtas(O2SM_HANDLER_ARGS)
 {
     int32_t id = argv[0]->i;
@@ -164,7 +179,7 @@ void arco_tableosc_createtcs(O2SM_HANDLER_ARGS)
     // end unpack message
 
     UGEN_FROM_ID(Tableosc, tableosc, id, "arco_tableosc_createtcs");
-    tableosc->create_tas(index, tlen, slen, data);
+    tableosc->create_tcs(index, tlen, slen, data);
 }
 
 
@@ -201,6 +216,8 @@ static void tableosc_init()
                     true, true);
     o2sm_method_new("/arco/tableosc/borrow", "ii", arco_tableosc_borrow,
                     NULL, true, true);
+    o2sm_method_new("/arco/tableosc/bank", "i", arco_tableosc_bank, NULL,
+                    true, true);
     // END INTERFACE INITIALIZATION
     o2sm_method_new("/arco/tableosc/createtas", "iiivf",
                     arco_tableosc_createtas, NULL, true, true);
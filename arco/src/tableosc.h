@@ -18,8 +18,8 @@ public:
     };
     int which_table;
     Vec<Tableosc_state> states;
-    void (Tableosc::*run_channel)(Tableosc_state *state,
-                                  Sample *table, int tlen);
+    void (Tableosc::*run_channel)(Tableosc_state *state, Sample *table,
+                                  Sample *table2, float w, int tlen);
 
 
     Ugen_ptr freq;
@@ -130,7 +130,21 @@ public:
     }
 
 
-    void chan_aa_a(Tableosc_state *state, Sample *table, int tlen) {
+    // interpolate table and table2 at phase (ix, frac) and crossfade,
+    // returning w * table2 + (1 - w) * table, scaled by 2^32:
+    static float lookup(Sample *table, Sample *table2, float w, int ix,
+                        float frac) {
+        float x = table[ix] * (0x100000000 - frac) + table[ix + 1] * frac;
+        if (table2 == table) {
+            return x;
+        }
+        float x2 = table2[ix] * (0x100000000 - frac) + table2[ix + 1] * frac;
+        return x + w * (x2 - x);
+    }
+
+
+    void chan_aa_a(Tableosc_state *state, Sample *table, Sample *table2,
+                   float w, int tlen) {
         int64_t phase = state->phase;
         int64_t tlen_mask = ((int64_t) tlen << 32) - 1;
         float freq_scale = freq_to_phase_incr * tlen;
@@ -140,15 +154,16 @@ public:
             phase &= tlen_mask;
             int ix = phase >> 32;
             float frac = phase & 0xFFFFFFFF;
-            *out_samps++ = (table[ix] * (0x100000000 - frac) + 
-                            table[ix + 1] * frac) * amp_samps[i] * fix_to_float;
+            *out_samps++ = lookup(table, table2, w, ix, frac) *
+                           amp_samps[i] * fix_to_float;
             phase += freq_samps[i] * freq_scale;
         }
         state->phase = phase;
     }
 
 
-    void chan_ba_a(Tableosc_state *state, Sample *table, int tlen) {
+    void chan_ba_a(Tableosc_state *state, Sample *table, Sample *table2,
+                   float w, int tlen) {
         int64_t phase = state->phase;
         int64_t tlen_mask = ((int64_t) tlen << 32) - 1;
         double phase_incr = *freq_samps * freq_to_phase_incr * tlen;
@@ -158,14 +173,15 @@ public:
             phase &= tlen_mask;
             int ix = phase >> 32;
             float frac = phase & 0xFFFFFFFF;
-            *out_samps++ = (table[ix] * (0x100000000 - frac) + 
-                            table[ix + 1] * frac) * amp_samps[i] * fix_to_float;
+            *out_samps++ = lookup(table, table2, w, ix, frac) *
+                           amp_samps[i] * fix_to_float;
             phase += phase_incr;
         }
         state->phase = phase;
     }
 
-    void chan_ab_a(Tableosc_state *state, Sample *table, int tlen) {
+    void chan_ab_a(Tableosc_state *state, Sample *table, Sample *table2,
+                   float w, int tlen) {
         int64_t phase = state->phase;
         int64_t tlen_mask = ((int64_t) tlen << 32) - 1;
         float freq_scale = freq_to_phase_incr * tlen;
@@ -180,15 +196,15 @@ public:
             int ix = phase >> 32;
             float frac = phase & 0xFFFFFFFF;
             amp_sig_fast += amp_sig_incr;
-            *out_samps++ = (table[ix] * (0x100000000 - frac) + 
-                            table[ix + 1] * frac) * amp_sig_fast;
+            *out_samps++ = lookup(table, table2, w, ix, frac) * amp_sig_fast;
             phase += freq_samps[i] * freq_scale;
         }
         state->phase = phase;
     }
 
 
-    void chan_bb_a(Tableosc_state *state, Sample *table, int tlen) {
+    void chan_bb_a(Tableosc_state *state, Sample *table, Sample *table2,
+                   float w, int tlen) {
         int64_t phase = state->phase;
         int64_t tlen_mask = ((int64_t) tlen << 32) - 1;
         double phase_incr = *freq_samps * freq_to_phase_incr * tlen;
@@ -203,8 +219,7 @@ public:
             int ix = phase >> 32;
             float frac = phase & 0xFFFFFFFF;
             amp_sig_fast += amp_sig_incr;
-            *out_samps++ = (table[ix] * (0x100000000 - frac) + 
-                            table[ix + 1] * frac) * amp_sig_fast;
+            *out_samps++ = lookup(table, table2, w, ix, frac) * amp_sig_fast;
             phase += phase_incr;
         }
         state->phase = phase;
@@ -225,7 +240,10 @@ public:
             return;
         }
         for (int i = 0; i < chans; i++) {
-            (this->*run_channel)(state, table->get_array(), tlen);
+            // pick band-limited levels by the frequency at block start:
+            Sample *t0, *t1;
+            float w = table->levels_for(*freq_samps, AR * 0.5f, &t0, &t1);
+            (this->*run_channel)(state, t0, t1, w, tlen);
             state++;
             freq_samps += freq_stride;
             amp_samps += amp_stride;
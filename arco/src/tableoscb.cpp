@@ -5,6 +5,9 @@
  */
 
 #include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
+#include "offload.h"
 #include "wavetables.h"
 #include "tableoscb.h"
 
@@ -141,6 +144,18 @@ void arco_tableoscb_borrow(O2SM_HANDLER_ARGS)
 }
 
 
+/* O2SM INTERFACE: /arco/tableoscb/bank int32 id;
+ */
+void arco_tableoscb_bank(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Tableoscb, tableoscb, id, "arco_tableoscb_bank");
+    tableoscb->borrow(wavetable_bank());
+}
+
 void arco_tableoscb_createtas(O2SM_HANDLER_ARGS)
 {
     // begin unpack message (machine-generated):
@@ -167,7 +182,7 @@ void arco_tableoscb_createtcs(O2SM_HANDLER_ARGS)
     // end unpack message
 
     UGEN_FROM_ID(Tableoscb, tableoscb, id, "arco_tableoscb_createtcs");
-    tableoscb->create_tas(index, tlen, slen, data);
+    tableoscb->create_tcs(index, tlen, slen, data);
 }
 
 
@@ -204,6 +219,8 @@ static void tableoscb_init()
                     NULL, true, true);
     o2sm_method_new("/arco/tableoscb/borrow", "ii", arco_tableoscb_borrow,
                     NULL, true, true);
+    o2sm_method_new("/arco/tableoscb/bank", "i", arco_tableoscb_bank, NULL,
+                    true, true);
     // END INTERFACE INITIALIZATION
     o2sm_method_new("/arco/tableoscb/createtas", "iiivf",
                     arco_tableoscb_createtas, NULL, true, true);
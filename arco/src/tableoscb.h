@@ -9,9 +9,8 @@ extern const char *Tableoscb_name;
 class Tableoscb : public Wavetables {
 public:
     struct Tableoscb_state {
-        double phase;
+        uint32_t phase;  // fixed-point phase, 2^32 is one period
     };
-    double phase_scale;
     int which_table;
     Sample *table;
     Vec<Tableoscb_state> states;
@@ -30,7 +29,7 @@ public:
         which_table = 0;
         states.set_size(chans);
         for (int i = 0; i < chans; i++) {
-            states[i].phase = fmodf(phase / 360.0f, 1.0f);
+            set_phase(i, phase);
         }
         init_freq(freq_);
         init_amp(amp_);
@@ -81,14 +80,16 @@ public:
     }
 
     void set_phase(int chan, float f) {
-        states[chan].phase = fmodf(f / 360.0f, 1.0f);
+        // negative phases wrap around, as they should:
+        states[chan].phase = (uint32_t) (int64_t) (fmodf(f / 360.0f, 1.0f) *
+                                                   4294967296.0);
     }
 
     void init_amp(Ugen_ptr ugen) { init_param(ugen, amp, &amp_stride); }
 
 
     void select(int i) {  // select table
-        if (i >= 0 && i < wavetables.size()) {
+        if (i >= 0 && i < num_tables()) {  // tables may be borrowed
             which_table = i;
         }
     }
@@ -106,18 +107,22 @@ public:
         if (tlen < 2) {
             return;
         }
+        assert(((tlen - 1) & tlen) == 0);
+        // tlen is a power of 2, so the table index is the high bits of
+        // phase and the low bits are the interpolation fraction:
+        int shift = 32 - ilog2(tlen);
+        uint32_t frac_mask = ((uint32_t) 1 << shift) - 1;
+        float frac_scale = 1.0f / (float) ((uint32_t) 1 << shift);
         float *waveform = table->get_array();
         for (int i = 0; i < chans; i++) {
-            double phase = state->phase;
-            float x = phase * tlen;
-            int ix = x;
-            float frac = x - ix;
+            uint32_t phase = state->phase;
+            int ix = phase >> shift;
+            float frac = (phase & frac_mask) * frac_scale;
             *out_samps++ = (waveform[ix] * (1 - frac) +
                             waveform[ix + 1] * frac) * *amp_samps;
-            phase += *freq_samps * AP;
-            while (phase > 1) phase--;
-            while (phase < 0) phase++;
-            state->phase = phase;
+            // wrap-around is unsigned overflow:
+            state->phase = phase + (uint32_t) (int64_t) (*freq_samps * AP *
+                                                         4294967296.0);
             state++;
             freq_samps += freq_stride;
             amp_samps += amp_stride;
@@ -196,6 +196,14 @@ class Ugen : public O2obj {
     
     virtual void real_run() = 0;
 
+    // analysis ugens that send results in messages (Yin, Onset, ...)
+    // also keep their latest results for Featurevec: return how many
+    // values there are, set *values to them and *frame_count to the
+    // number of analysis frames so far (so callers can tell new values)
+    virtual int get_features(Sample_ptr *values, int *frame_count) {
+        return 0;
+    }
+
     virtual Sample_ptr run(int block_count) {
         Sample_ptr save_out_samps = out_samps;
         if (block_count > current_block) {
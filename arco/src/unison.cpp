@@ -0,0 +1,289 @@
+/* unison.cpp - detuned multi-voice table-lookup oscillator
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+#include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
+#include "offload.h"
+#include "wavetables.h"
+#include "unison.h"
+
+const char *Unison_name = "Unison";
+
+
+void Unison::real_run()
+{
+    freq_samps = freq->run(current_block);  // update inputs
+    detune_samps = detune->run(current_block);
+    amp_samps = amp->run(current_block);
+    block_zero_n(out_samps, chans);
+    Wavetable *table = get_table(which_table);
+    if (!table) {
+        return;
+    }
+    int tlen = table->size() - 2;
+    if (tlen < 2) {
+        return;
+    }
+    if (gains_changed) {
+        update_gains();
+    } else if (gains_ramping) {  // ramps finished in the previous block
+        gain_incrs.zero();
+        gains_ramping = false;
+    }
+
+    int shift = 32 - ilog2(tlen);  // phase bits below the table index
+    uint32_t frac_mask = ((uint32_t) 1 << shift) - 1;
+    float frac_scale = 1.0f / (float) ((uint32_t) 1 << shift);
+    float f0 = *freq_samps;
+    float dt = *detune_samps;
+
+    // one pair of mip levels for all voices, chosen for the highest:
+    Sample *t0, *t1;
+    float w = table->levels_for(fabsf(f0) + fabsf(dt), AR * 0.5f, &t0, &t1);
+
+    Sample *left = out_samps;
+    Sample *right = out_samps + BL;  // used only if chans == 2
+    uint32_t ph[BL];
+    Sample x[BL];
+    for (int v = 0; v < voices; v++) {
+        float spread = (voices > 1 ? (v * 2.0f) / (voices - 1) - 1 : 0);
+        // negative frequencies wrap around to large increments, which
+        // is what we want since phase arithmetic is modulo 2^32:
+        uint32_t incr = (uint32_t) (int64_t) ((f0 + dt * spread) * AP *
+                                              4294967296.0);
+        uint32_t phase = phases[v];
+        for (int i = 0; i < BL; i++) {
+            ph[i] = phase + incr * i;
+        }
+        phases[v] = phase + incr * BL;
+
+        for (int i = 0; i < BL; i++) {
+            uint32_t ix = ph[i] >> shift;
+            float frac = (ph[i] & frac_mask) * frac_scale;
+            x[i] = t0[ix] + frac * (t0[ix + 1] - t0[ix]);
+        }
+        if (t1 != t0) {  // crossfade to the next band-limited level
+            for (int i = 0; i < BL; i++) {
+                uint32_t ix = ph[i] >> shift;
+                float frac = (ph[i] & frac_mask) * frac_scale;
+                float x1 = t1[ix] + frac * (t1[ix + 1] - t1[ix]);
+                x[i] += w * (x1 - x[i]);
+            }
+        }
+
+        float gl = gains[v * 2];
+        float gl_incr = gain_incrs[v * 2];
+        for (int i = 0; i < BL; i++) {
+            left[i] += x[i] * (gl + gl_incr * (i + 1));
+        }
+        gains[v * 2] = gl + gl_incr * BL;
+        if (chans == 2) {
+            float gr = gains[v * 2 + 1];
+            float gr_incr = gain_incrs[v * 2 + 1];
+            for (int i = 0; i < BL; i++) {
+                right[i] += x[i] * (gr + gr_incr * (i + 1));
+            }
+            gains[v * 2 + 1] = gr + gr_incr * BL;
+        }
+    }
+
+    // apply amplitude, interpolated from the previous block:
+    Sample amp_sig = *amp_samps;
+    Sample amp_incr = (amp_sig - prev_amp) * BL_RECIP;
+    for (int chan = 0; chan < chans; chan++) {
+        Sample *out = out_samps + chan * BL;
+        for (int i = 0; i < BL; i++) {
+            out[i] *= prev_amp + amp_incr * (i + 1);
+        }
+    }
+    prev_amp = amp_sig;
+}
+
+
+/* O2SM INTERFACE: /arco/unison/new int32 id, int32 chans, int32 voices,
+       int32 freq, int32 detune, int32 amp, float rolloff, float width;
+ */
+void arco_unison_new(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chans = argv[1]->i;
+    int32_t voices = argv[2]->i;
+    int32_t freq = argv[3]->i;
+    int32_t detune = argv[4]->i;
+    int32_t amp = argv[5]->i;
+    float rolloff = argv[6]->f;
+    float width = argv[7]->f;
+    // end unpack message
+
+    ANY_UGEN_FROM_ID(freq_ugen, freq, "arco_unison_new");
+    ANY_UGEN_FROM_ID(detune_ugen, detune, "arco_unison_new");
+    ANY_UGEN_FROM_ID(amp_ugen, amp, "arco_unison_new");
+    new Unison(id, chans, voices, freq_ugen, detune_ugen, amp_ugen,
+               rolloff, width);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/repl_freq int32 id, int32 freq_id;
+ */
+static void arco_unison_repl_freq(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t freq_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_repl_freq");
+    ANY_UGEN_FROM_ID(freq, freq_id, "arco_unison_repl_freq");
+    unison->repl_freq(freq);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/set_freq int32 id, int32 chan, float freq;
+ */
+static void arco_unison_set_freq(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chan = argv[1]->i;
+    float freq = argv[2]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_set_freq");
+    unison->set_freq(chan, freq);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/repl_detune int32 id, int32 detune_id;
+ */
+static void arco_unison_repl_detune(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t detune_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_repl_detune");
+    ANY_UGEN_FROM_ID(detune, detune_id, "arco_unison_repl_detune");
+    unison->repl_detune(detune);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/set_detune int32 id, int32 chan, float detune;
+ */
+static void arco_unison_set_detune(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chan = argv[1]->i;
+    float detune = argv[2]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_set_detune");
+    unison->set_detune(chan, detune);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/repl_amp int32 id, int32 amp_id;
+ */
+static void arco_unison_repl_amp(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t amp_id = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_repl_amp");
+    ANY_UGEN_FROM_ID(amp, amp_id, "arco_unison_repl_amp");
+    unison->repl_amp(amp);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/set_amp int32 id, int32 chan, float amp;
+ */
+static void arco_unison_set_amp(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t chan = argv[1]->i;
+    float amp = argv[2]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_set_amp");
+    unison->set_amp(chan, amp);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/rolloff int32 id, float rolloff;
+ */
+static void arco_unison_rolloff(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    float rolloff = argv[1]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_rolloff");
+    unison->set_rolloff(rolloff);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/width int32 id, float width;
+ */
+static void arco_unison_width(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    float width = argv[1]->f;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_width");
+    unison->set_width(width);
+}
+
+
+/* O2SM INTERFACE: /arco/unison/sel int32 id, int32 index;
+ */
+static void arco_unison_sel(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t id = argv[0]->i;
+    int32_t index = argv[1]->i;
+    // end unpack message
+
+    UGEN_FROM_ID(Unison, unison, id, "arco_unison_sel");
+    unison->select(index);
+}
+
+
+static void unison_init()
+{
+    // O2SM INTERFACE INITIALIZATION: (machine generated)
+    o2sm_method_new("/arco/unison/new", "iiiiiiff", arco_unison_new, NULL,
+                    true, true);
+    o2sm_method_new("/arco/unison/repl_freq", "ii", arco_unison_repl_freq,
+                    NULL, true, true);
+    o2sm_method_new("/arco/unison/set_freq", "iif", arco_unison_set_freq,
+                    NULL, true, true);
+    o2sm_method_new("/arco/unison/repl_detune", "ii",
+                    arco_unison_repl_detune, NULL, true, true);
+    o2sm_method_new("/arco/unison/set_detune", "iif",
+                    arco_unison_set_detune, NULL, true, true);
+    o2sm_method_new("/arco/unison/repl_amp", "ii", arco_unison_repl_amp,
+                    NULL, true, true);
+    o2sm_method_new("/arco/unison/set_amp", "iif", arco_unison_set_amp,
+                    NULL, true, true);
+    o2sm_method_new("/arco/unison/rolloff", "if", arco_unison_rolloff,
+                    NULL, true, true);
+    o2sm_method_new("/arco/unison/width", "if", arco_unison_width, NULL,
+                    true, true);
+    o2sm_method_new("/arco/unison/sel", "ii", arco_unison_sel, NULL, true,
+                    true);
+    // END INTERFACE INITIALIZATION
+}
+
+Initializer unison_init_obj(unison_init);
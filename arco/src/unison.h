@@ -0,0 +1,191 @@
+/* unison.h -- detuned multi-voice table-lookup oscillator
+ *
+ * Roger B. Dannenberg
+ * Oct 2026
+ */
+
+/* Unison plays `voices` copies of a table from the wavetable bank
+ * (see wavetables.h) with frequencies spaced evenly from freq - detune
+ * to freq + detune, as in a "supersaw." With 1 channel, voices are
+ * summed. With 2 channels, voices are spread across the stereo field
+ * according to width (0 = all centered, 1 = lowest voice left and
+ * highest voice right). Voices are weighted by rolloff^k, where k is
+ * the distance from the center voice, and normalized for constant
+ * power.
+ *
+ * This does the work of many Tableosc's plus a Sum or Stdistr, but
+ * with one Ugen, one table and mip level selection per block, and one
+ * amplitude ramp for all voices.
+ *
+ * Phase: each voice has a 32-bit unsigned phase where 2^32 is one
+ * period. Tables have power-of-2 lengths, so the table index is the
+ * top log2(tlen) bits of phase, the rest is the interpolation
+ * fraction, and wrap-around is free (integer overflow). Phases for a
+ * block are computed in their own loop so that it vectorizes.
+ */
+
+extern const char *Unison_name;
+
+class Unison : public Wavetables {
+public:
+    int voices;
+    int which_table;
+    Vec<uint32_t> phases;  // phase of each voice
+    Vec<float> gains;      // left (or mono) and right gain of each voice
+    Vec<float> gain_incrs; // per-sample gain increments while changing
+    float rolloff;
+    float width;
+    bool gains_changed;  // gains must be recomputed
+    bool gains_ramping;  // gain_incrs are non-zero
+    Sample prev_amp;
+
+    Ugen_ptr freq;
+    Sample_ptr freq_samps;
+
+    Ugen_ptr detune;
+    Sample_ptr detune_samps;
+
+    Ugen_ptr amp;
+    Sample_ptr amp_samps;
+
+
+    Unison(int id, int nchans, int voices_, Ugen_ptr freq_, Ugen_ptr detune_,
+           Ugen_ptr amp_, float rolloff_, float width_) :
+            Wavetables(id, 'a', MIN(nchans, 2)) {
+        if (nchans > 2) {
+            arco_warn("Unison: %d channels requested, using 2", nchans);
+        }
+        voices = MAX(voices_, 1);
+        which_table = 0;
+        phases.set_size(voices);
+        // spread initial phases by the golden ratio so that voices do not
+        // start in phase, which would make a loud "click" at the onset:
+        for (int v = 0; v < voices; v++) {
+            phases[v] = (uint32_t) v * 0x9E3779B9u;
+        }
+        gains.set_size(voices * 2);  // all zero, so the first block ramps up
+        gain_incrs.set_size(voices * 2);
+        rolloff = rolloff_;
+        width = width_;
+        gains_changed = true;
+        gains_ramping = false;
+        prev_amp = 0;
+        tail_blocks = 1;  // amplitude ramps to zero after amp terminates
+        init_freq(freq_);
+        init_detune(detune_);
+        init_amp(amp_);
+        borrow(wavetable_bank());
+    }
+
+    ~Unison() {
+        freq->unref(&freq);
+        detune->unref(&detune);
+        amp->unref(&amp);
+    }
+
+    const char *classname() { return Unison_name; }
+
+    void print_details(int indent) {
+        arco_print("voices %d table %d rolloff %g width %g", voices,
+                   which_table, rolloff, width);
+    }
+
+    void print_sources(int indent, bool print_flag) {
+        freq->print_tree(indent, print_flag, "freq");
+        detune->print_tree(indent, print_flag, "detune");
+        amp->print_tree(indent, print_flag, "amp");
+    }
+
+    // controls are used at block rate, so downsample audio-rate inputs:
+    Ugen_ptr block_rate(Ugen_ptr ugen) {
+        if (ugen->rate == 'a') {
+            ugen = new Dnsampleb(-1, ugen->chans, ugen, LOWPASS500);
+        } else {
+            ugen->ref();
+        }
+        return ugen;
+    }
+
+    void repl_freq(Ugen_ptr ugen) {
+        freq->unref(&freq);
+        init_freq(ugen);
+    }
+
+    void set_freq(int chan, float f) {
+        freq->const_set(chan, f, "Unison::set_freq");
+    }
+
+    void init_freq(Ugen_ptr ugen) { freq = block_rate(ugen); }
+
+    void repl_detune(Ugen_ptr ugen) {
+        detune->unref(&detune);
+        init_detune(ugen);
+    }
+
+    void set_detune(int chan, float f) {
+        detune->const_set(chan, f, "Unison::set_detune");
+    }
+
+    void init_detune(Ugen_ptr ugen) { detune = block_rate(ugen); }
+
+    void repl_amp(Ugen_ptr ugen) {
+        amp->unref(&amp);
+        init_amp(ugen);
+    }
+
+    void set_amp(int chan, float f) {
+        amp->const_set(chan, f, "Unison::set_amp");
+    }
+
+    void init_amp(Ugen_ptr ugen) { amp = block_rate(ugen); }
+
+    void set_rolloff(float r) {
+        rolloff = r;
+        gains_changed = true;
+    }
+
+    void set_width(float w) {
+        width = w;
+        gains_changed = true;
+    }
+
+    void select(int i) {  // select table from the bank
+        if (i >= 0 && i < num_tables()) {
+            which_table = i;
+        }
+    }
+
+
+    // compute gains for the current rolloff and width and set up
+    // increments to reach them by the end of the next block
+    void update_gains() {
+        // the center voice (or pair of voices if voices is even) is at
+        // distance 0.5 * ((voices - 1) & 1) from the center:
+        float center = (voices - 1) * 0.5f;
+        float kmin = center - (int) center;
+        float power = 0;
+        for (int v = 0; v < voices; v++) {
+            float g = powf(rolloff, fabsf(v - center) - kmin);
+            gain_incrs[v * 2] = g;  // temporary
+            power += g * g;
+        }
+        float norm = 1.0f / sqrtf(power);
+        for (int v = 0; v < voices; v++) {
+            float g = gain_incrs[v * 2] * norm;
+            float left = g, right = 0;
+            if (chans == 2) {
+                float pan = (voices > 1 ? (float) v / (voices - 1) : 0.5f) *
+                            width + (0.5f - width * 0.5f);
+                left = g * cosf(pan * (float) M_PI_2);
+                right = g * sinf(pan * (float) M_PI_2);
+            }
+            gain_incrs[v * 2] = (left - gains[v * 2]) * BL_RECIP;
+            gain_incrs[v * 2 + 1] = (right - gains[v * 2 + 1]) * BL_RECIP;
+        }
+        gains_changed = false;
+        gains_ramping = true;
+    }
+
+
+    void real_run();
+};
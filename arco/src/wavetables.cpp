@@ -4,6 +4,196 @@
  * Oct 2024
  */
 
+#include "arcougen.h"
+#include "o2atomic.h"
+#include "bufferpool.h"
+#include "offload.h"
+#include "wavetables.h"
+
+
+Wavetable_job::Wavetable_job(Wavetables *owner_, int index_, int tlen_,
+                             int slen_, float *data_, int kind_)
+{
+    owner = owner_;
+    owner->ref();  // do not delete owner until finish()
+    index = index_;
+    tlen = tlen_;
+    slen = slen_;
+    data = O2_MALLOCNT(slen, float);
+    memcpy(data, data_, slen * sizeof(float));
+    kind = kind_;
+    table.init(0);
+}
+
+
+Wavetable_job::~Wavetable_job()
+{
+    O2_FREE(data);
+    table.finish();
+}
+
+
+// Build the table and its mip levels (see "Band-limiting" in
+// wavetables.h) from a spectrum, bins, in the order used by rffts()
+// and riffts(): DC, Nyquist, then (re, im) for each harmonic. Harmonic
+// h with amplitude A and phase φ, A sin(2πhn/N + φ), is bin h with
+// value (N/2) A e^(i(φ-π/2)) (riffts() scales by 1/N). Harmonics at or
+// above N/2 would alias, so they are omitted.
+void Wavetable_job::run()
+{
+    int m = ilog2(tlen);
+    // FFT setup allocates, so do it here on the main thread. Setups are
+    // published atomically and never freed while running, so the audio
+    // thread can safely use (or race to create) the same one.
+    fftInit(m);
+    Vec<float> bins(tlen, true);
+    float *spec = &bins[0];
+    if (kind == WT_SAMPLES) {
+        memcpy(spec, data, tlen * sizeof(float));
+        rffts(spec, m, 1);
+    } else {
+        bool hasphase = (kind == WT_CPLXSPEC);
+        int harm = 1;  // harmonic number
+        for (int h = 0; h < slen - hasphase && harm < tlen / 2;
+             h += 1 + hasphase) {
+            float amp = data[h] * tlen * 0.5f;
+            double phase = (hasphase ? data[h + 1] :
+                                       Wavetables::schroeder_phase(h, slen));
+            spec[harm * 2] = amp * sin(phase);
+            spec[harm * 2 + 1] = -amp * cos(phase);
+            harm++;
+        }
+    }
+
+    // find the highest harmonic above -80 dB relative to the peak:
+    float peak = 0;
+    for (int h = 1; h < tlen / 2; h++) {
+        peak = fmaxf(peak, hypotf(spec[h * 2], spec[h * 2 + 1]));
+    }
+    int harmonics = 0;
+    for (int h = tlen / 2 - 1; h > 0; h--) {
+        if (hypotf(spec[h * 2], spec[h * 2 + 1]) > peak * 1e-4f) {
+            harmonics = h;
+            break;
+        }
+    }
+    int levels = 0;
+    while ((harmonics >> (levels + 1)) > 0) {
+        levels++;
+    }
+
+    table.init(tlen + 2);
+    table.set_size(tlen + 2, false);
+    table.harmonics = harmonics;
+    table.mip_levels = levels;
+    table.mips.init(levels * (tlen + 2));
+    table.mips.set_size(levels * (tlen + 2), false);
+    make_level(table.get_array(), spec, tlen / 2);
+    if (kind == WT_SAMPLES) {  // the original samples are more precise
+        memcpy(table.get_array(), data, tlen * sizeof(float));
+    }
+    for (int k = 1; k <= levels; k++) {
+        make_level(table.level(k), spec, harmonics >> k);
+    }
+    for (int k = 0; k <= levels; k++) {
+        float *samps = table.level(k);
+        samps[tlen] = samps[0];
+        samps[tlen + 1] = samps[1];
+    }
+    bins.finish();
+}
+
+
+// make one level in dst from harmonics 0 through max_harmonic of bins
+void Wavetable_job::make_level(float *dst, float *bins, int max_harmonic)
+{
+    int n = MIN(max_harmonic + 1, tlen / 2) * 2;
+    memcpy(dst, bins, n * sizeof(float));
+    memset(dst + n, 0, (tlen - n) * sizeof(float));
+    dst[1] = (max_harmonic >= tlen / 2 ? bins[1] : 0);  // Nyquist
+    riffts(dst, ilog2(tlen), 1);
+}
+
+
+void Wavetable_job::finish()
+{
+    owner->install_table(index, table);
+    owner->unref((Ugen **) &owner);
+}
+
+
+class Wavetable_bank : public Wavetables {
+  public:
+    // id -1: the bank is not in ugen_table, so reset cannot free it
+    Wavetable_bank() : Wavetables(-1, 'c', 1) { }
+
+    const char *classname() { return "Wavetable_bank"; }
+
+    void real_run() { }
+};
+
+
+Wavetables *wavetable_bank()
+{
+    static Wavetables *bank = NULL;
+    if (!bank) {
+        bank = new Wavetable_bank();
+    }
+    return bank;
+}
+
+
+void arco_wtbank_createtas(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t index = argv[0]->i;
+    int32_t tlen = argv[1]->i;
+    int slen = argv[2]->v.len;
+    float *data = argv[2]->v.vf;
+    // end unpack message
+
+    wavetable_bank()->create_tas(index, tlen, slen, data);
+}
+
+
+void arco_wtbank_createtcs(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t index = argv[0]->i;
+    int32_t tlen = argv[1]->i;
+    int slen = argv[2]->v.len;
+    float *data = argv[2]->v.vf;
+    // end unpack message
+
+    wavetable_bank()->create_tcs(index, tlen, slen, data);
+}
+
+
+void arco_wtbank_createttd(O2SM_HANDLER_ARGS)
+{
+    // begin unpack message (machine-generated):
+    int32_t index = argv[0]->i;
+    int tlen = argv[1]->v.len;
+    float *data = argv[1]->v.vf;
+    // end unpack message
+
+    wavetable_bank()->create_ttd(index, tlen, data);
+}
+
+
+static void wtbank_init()
+{
+    o2sm_method_new("/arco/wtbank/createtas", "iivf",
+                    arco_wtbank_createtas, NULL, true, true);
+    o2sm_method_new("/arco/wtbank/createtcs", "iivf",
+                    arco_wtbank_createtcs, NULL, true, true);
+    o2sm_method_new("/arco/wtbank/createttd", "ivf",
+                    arco_wtbank_createttd, NULL, true, true);
+}
+
+Initializer wtbank_init_obj(wtbank_init);
+
+
 float sine_table[1025] = {
     0, 0.00613588, 0.0122715, 0.0184067, 0.0245412, 
     0.0306748, 0.0368072, 0.0429383, 0.0490677, 0.0551952, 
@@ -7,14 +7,104 @@
 /* wavetables of length n represent a period of length n-2 where
  * w[0] repeats at w[n-2] and w[1] repeats at w[n-1] to simplify
  * interpolation.
+ *
+ * Band-limiting: a table played at a high frequency aliases when its
+ * harmonics exceed the Nyquist frequency. Therefore, when a table of
+ * power-of-2 length is built, we also build "mip levels": level k
+ * keeps only harmonics up to harmonics >> k, so there is one level
+ * per octave down to a sine. Level 0 is the table itself. To play at
+ * frequency f, let x = log2(f * harmonics / nyquist), so every level
+ * k >= x is free of aliasing. We crossfade from level ceil(x) to
+ * level ceil(x) + 1 as x goes from ceil(x) - 1 to ceil(x), which is
+ * continuous in f and never aliases (at the cost of removing up to an
+ * octave of the highest harmonics). See levels_for(). Oscillators
+ * choose levels once per block, so a frequency that rises within a
+ * block can alias until the next block. Every level is a full copy of
+ * size() floats (although higher levels could be shorter) so that all
+ * levels share one phase and length; a table with h harmonics takes
+ * about log2(h) + 1 times the memory of the table alone.
  */
 #include "ffts_compat.h"  // for ilog2()
 
-typedef Vec<float> Wavetable;
+class Wavetable : public Vec<float> {
+public:
+    Vec<float> mips;  // mip levels 1 through mip_levels, each of size()
+    int mip_levels;   // how many levels in mips
+    int harmonics;    // highest harmonic, 0 if table is not band-limited
+
+    void init(int siz) {
+        Vec<float>::init(siz);
+        mips.init(0);
+        mip_levels = 0;
+        harmonics = 0;
+    }
+
+    void finish() {
+        Vec<float>::finish();
+        mips.finish();
+    }
+
+    float *level(int k) {
+        return k == 0 ? get_array() : &mips[(k - 1) * size()];
+    }
+
+    // get the two levels to play at freq and return the weight of *t1
+    // (see "Band-limiting" above)
+    float levels_for(float freq, float nyquist, float **t0, float **t1) {
+        float x = (mip_levels == 0 ? -1 :
+                   log2f(fabsf(freq) * harmonics / nyquist));
+        if (x <= -1) {  // all harmonics are below nyquist / 2
+            *t0 = *t1 = get_array();
+            return 0;
+        }
+        int a = (int) ceilf(x);
+        if (a >= mip_levels) {  // even the highest harmonic is too high
+            *t0 = *t1 = level(mip_levels);
+            return 0;
+        }
+        *t0 = level(a);
+        *t1 = level(a + 1);
+        return x - a + 1;
+    }
+};
 
 const int sine_table_len = 1024;
 extern float sine_table[sine_table_len + 1];
 
+class Wavetables;
+
+// kinds of data used to build a table:
+const int WT_AMPSPEC = 0;   // harmonic amplitudes
+const int WT_CPLXSPEC = 1;  // harmonic (amplitude, phase) pairs
+const int WT_SAMPLES = 2;   // one period of samples
+
+// Tables and their mip levels are built by FFTs on the main thread
+// (see offload.h) because a large table can take long enough to cause
+// an audio dropout. When the job finishes, the new table replaces the
+// old one between audio blocks, so an oscillator never sees a
+// partially built table. Until then, the old table (or none) is played.
+class Wavetable_job : public Offload_job {
+  public:
+    Wavetables *owner;
+    int index;      // which table to replace
+    int tlen;       // table length, a power of 2
+    int slen;       // length of data
+    float *data;    // copy of spectrum or samples
+    int kind;       // WT_AMPSPEC, WT_CPLXSPEC or WT_SAMPLES
+    Wavetable table;  // the table built by run()
+
+    Wavetable_job(Wavetables *owner_, int index_, int tlen_, int slen_,
+                  float *data_, int kind_);
+
+    ~Wavetable_job();
+
+    void run();
+
+    void make_level(float *dst, float *bins, int max_harmonic);
+
+    void finish();
+};
+
 class Wavetables : public Ugen {
 public:
     Vec<Wavetable> wavetables;
@@ -51,8 +141,11 @@ public:
 
 
     void borrow(Wavetables *wt) {
+        wt->ref();  // ref first in case wt == lender
+        if (lender) {
+            lender->unref((Ugen **) &lender);
+        }
         lender = wt;
-        lender->ref();
     }
 
 
@@ -74,53 +167,53 @@ public:
     }
 
 
-    void create_table_at(int i, int tlen) {
-        // if i > size, extend wavetables and initialize to empty wavetables
+    static int round_tlen(int tlen) {
         // round tlen up to the next power of 2 if needed
         if ((tlen & (tlen - 1)) != 0) {
             tlen = 1 << ilog2(tlen);
         }
+        return tlen;
+    }
+
+    void extend_tables(int i) {
+        // if i >= size, extend wavetables and initialize to empty wavetables
         int n = wavetables.size();
         if (n <= i) {
             wavetables.set_size(i + 1, false);
             for (; n < i + 1; n++) {
-                wavetables[i].init(0);
+                wavetables[n].init(0);
             }
         }
+    }
+
+    void create_table_at(int i, int tlen) {
+        tlen = round_tlen(tlen);
+        extend_tables(i);
         wavetables[i].set_size(tlen + 2, false);
     }
 
-    double schroeder_phase(int n, int slen) {
+    // replace table i with table, which is left empty. The old samples
+    // are freed by the main thread.
+    void install_table(int i, Wavetable &table) {
+        extend_tables(i);
+        Wavetable &dst = wavetables[i];
+        bufferpool_discard(dst.get_array());
+        bufferpool_discard(dst.mips.get_array());
+        // Vecs are relocatable, so move table to dst and forget table:
+        memcpy((void *) &dst, (void *) &table, sizeof(Wavetable));
+        table.init(0);
+    }
+
+    static double schroeder_phase(int n, int slen) {
         // here, n is zero-based, so use (n + 1) * n rather than n * (n - 1):
         return M_PI * (n + 1) * n / slen;
     }
 
     // Uses Schroeder's formula for phase, intended to reduce crest factor
     // by avoiding all in-phase harmonics: φ(n) = π * n * (n - 1) / N
-    void create_table(int i, int tlen, int slen, float *spec, bool hasphase) {
-        create_table_at(i, tlen);
-        // now wavetables[i] exists and is initialized but may be wrong size
-        Wavetable &table = wavetables[i];
-        tlen = table.size() - 2;  // length is rounded up to power of 2 + 2
-        table.zero();
-        int harm = 1;  // harmonic number
-        for (int h = 0; h < slen - hasphase; h += 1 + hasphase) {
-            float *data = &table[0];
-            float amp = spec[h];
-            double phase = (hasphase ? spec[h + 1] : schroeder_phase(h, slen));
-            double phase_incr = (double) harm * sine_table_len / tlen;
-            for (i = 0; i < tlen + 2; i++) {
-                int iphase = phase;
-                float phase_frac = phase - iphase;
-                *data++ += (sine_table[iphase] * (1 - phase_frac) +
-                            sine_table[iphase + 1] * phase_frac) * amp;
-                phase += phase_incr;
-                if (phase >= sine_table_len) {
-                    phase -= sine_table_len;
-                }
-            }
-            harm++;
-        }
+    void create_table(int i, int tlen, int slen, float *data, int kind) {
+        tlen = MAX(round_tlen(tlen), 32);  // smallest real FFT is 32
+        offload(new Wavetable_job(this, i, tlen, slen, data, kind));
     }
 
 
@@ -128,22 +221,32 @@ public:
     // tlen is the "period" of the table and 
     // the actual allocation size is tlen + 2
     void create_tas(int i, int tlen, int slen, float *ampspec) {
-        create_table(i, tlen, slen, ampspec, false);
+        create_table(i, tlen, slen, ampspec, WT_AMPSPEC);
     }
 
 
     // set ith table of length tlen from a complex spectrum (amplitude and
     // phase) of length alen. Phase is in *radians*.
     void create_tcs(int i, int tlen, int slen, float *spec) {
-        create_table(i, tlen, slen, spec, true);
+        create_table(i, tlen, slen, spec, WT_CPLXSPEC);
     }
 
 
-    // set ith table of length tlen from time domain data
+    // set ith table of length tlen from time domain data. If tlen is a
+    // power of 2 (at least 32), mip levels are built by the main thread.
     void create_ttd(int i, int tlen, float *samps) {
+        if (tlen >= 32 && (tlen & (tlen - 1)) == 0) {
+            create_table(i, tlen, tlen, samps, WT_SAMPLES);
+            return;
+        }
         create_table_at(i, tlen);
         // now wavetables[i] exists and is initialized but may be wrong size
         Wavetable &table = wavetables[i];
+        // drop mip levels of a previous table; the main thread frees them:
+        bufferpool_discard(table.mips.get_array());
+        table.mips.init(0);
+        table.mip_levels = 0;  // not band-limited
+        table.harmonics = 0;
         float *data = &table[0];
         memcpy(data, samps, tlen * sizeof(float));
         table[tlen] = samps[0];
@@ -151,3 +254,11 @@ public:
     }
 };
 
+
+// The wavetable bank holds tables shared by all Tableosc and Tableoscb
+// instances. It is not in ugen_table and is never freed, so any number
+// of oscillators can borrow() it and select() its tables by index
+// without building their own tables or keeping another Ugen alive.
+// Indices are allocated by the client (see wtbank_handle() in
+// tableosc.srp), so only one client may create bank tables.
+Wavetables *wavetable_bank();
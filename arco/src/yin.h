@@ -42,13 +42,14 @@ float parabolic_interp(float x1, float x2, float x3,
 
 class Yin : public Windowed_input {
   public:
-    struct Yin_state {
-        float harmonicity;
+    struct Yin_state {  // in message order; also the features
         float pitch;
+        float harmonicity;
         float rms;
     };
     Vec<Yin_state> yin_states;
     bool new_estimates; // set to true when yin runs
+    int feature_frames;  // count of estimates (see get_features())
     const char *address; // where to send messages
 
     int m;  // shortest period in samples
@@ -65,6 +66,7 @@ class Yin : public Windowed_input {
         results = O2_MALLOCNT(middle - m + 1, float);
         init_input(input);
         new_estimates = false;
+        feature_frames = 0;
         address = o2_heapify(address_);
     }
 
@@ -173,8 +175,8 @@ class Yin : public Windowed_input {
 
     void real_run() {
         Windowed_input::real_run();
-        if (new_estimates) {  // time to send a message
-            // message format is pitch0, harmo0, pitch1, harmo1, ...
+        if (new_estimates && address[0]) {  // time to send a message
+            // message format is pitch0, harmo0, rms0, pitch1, harmo1, ...
             o2sm_send_start();
             for (int channel = 0; channel < chans; channel++) {
                 Yin_state *ys = &yin_states[channel];
@@ -183,7 +185,18 @@ class Yin : public Windowed_input {
                 o2sm_add_float(ys->rms);
             }
             o2sm_send_finish(0, address, false);
+        }
+        if (new_estimates) {
+            feature_frames++;
             new_estimates = false;
         }
     }
+
+
+    // features are pitch, harmonicity and rms for each channel
+    int get_features(Sample_ptr *values, int *frame_count) {
+        *values = (Sample_ptr) &yin_states[0];
+        *frame_count = feature_frames;
+        return chans * 3;
+    }
 };
@@ -88,6 +88,7 @@ long pvst_offset = -1000; // -1 means we haven't seen first frame yet
 #include <string.h>
 #include <assert.h>
 #include <stdlib.h>
+#include <float.h>
 #include "internal.h"
 // only needed for some debugging code which is probably commented out
 #include "cmupvdbg.h"
@@ -188,6 +189,11 @@ typedef struct {
     float *pre_syn_phase; // recording last systhesis phase for rebuilting
                           // the new phase
     float *bin_freq; // bin frequency, used in phase unwrapping;
+    float *advance; // PV_MODE_PHASEFIX: standard synthesis phase per bin
+    int *peak_of; // PV_MODE_PHASEFIX: for each bin, the index of the
+                  // peak whose phase advance the bin shares
+    void *leader; // if non-NULL, the PV whose peaks and phase changes
+                  // are used instead of our own (see pv_set_link())
     
     struct position *pos_buffer; // Circular array storing the sample
                             // number of the middle of the frames
@@ -277,6 +283,8 @@ void pv_end(Phase_vocoder *x)
     PVFREE(pre_ana_phase);
     PVFREE(pre_syn_phase);
     PVFREE(bin_freq);
+    PVFREE(advance);
+    PVFREE(peak_of);
     PVFREE(pos_buffer);
     pv->free(pv);
     *x = NULL;
@@ -411,9 +419,14 @@ void pv_initialize(Phase_vocoder x)
     PVREALLOC(pre_syn_phase, pv->fftsize / 2 + 1);
     // bin frequency, used in phase unwrapping
     PVREALLOC(bin_freq, pv->fftsize / 2 + 1);
+    PVREALLOC(advance, pv->fftsize / 2 + 1);
+    PVFREE(peak_of);
+    pv->peak_of = (int *) pv->malloc((pv->fftsize / 2 + 1) * sizeof(int));
     int i;
-    for (i = 0; i <= pv->fftsize / 2; i++)
+    for (i = 0; i <= pv->fftsize / 2; i++) {
         pv->bin_freq[i] = (float) (TWOPI * i / pv->fftsize);
+        pv->peak_of[i] = i;  // every bin is its own peak until we look
+    }
     // get_effective_pos() maps from the beginning of the
     // next block to the corresponding input sample. Since
     // the output hopsize is fixed, the next output sample
@@ -466,6 +479,13 @@ void pv_set_mode(Phase_vocoder x, int mode)
 }
 
 
+void pv_set_link(Phase_vocoder x, Phase_vocoder leader)
+{
+    PV *pv = (PV*)x;
+    pv->leader = (leader == x ? NULL : leader);
+}
+
+
 float *pv_window(Phase_vocoder x, float (*window_type)(double x)) 
     // window is after normalized
 {
@@ -634,6 +654,230 @@ void pv_put_input(Phase_vocoder x, int size, float *samples)
 }
 
 
+/* Per-bin kernels. The loops over bins are written without library
+calls or data-dependent branches (conditional expressions compile to
+selects) so that compilers can vectorize them. pv_sqrtf(), pv_atan2f()
+and pv_sincosf() are approximations with errors around 1e-7, which is
+about the resolution of the floats they operate on.
+*/
+
+#define INV_TWOPI ((float) (1.0 / TWOPI))
+
+// wrap phase x to [-pi, pi]
+static inline float pv_wrapf(float x)
+{
+    float t = x * INV_TWOPI + 0.5f;
+    int k = (int) t;  // truncates toward zero, so adjust to get floor(t):
+    k -= (t < k);
+    return x - (float) TWOPI * k;
+}
+
+
+// sqrt using the "fast inverse square root" estimate and 3 Newton
+// iterations (relative error < 2e-7), v >= 0
+static inline float pv_sqrtf(float v)
+{
+    union { float f; int32_t i; } u;
+    u.f = v;
+    u.i = 0x5f3759df - (u.i >> 1);
+    float y = u.f;  // about 1 / sqrt(v)
+    float hv = 0.5f * v;
+    y = y * (1.5f - hv * y * y);
+    y = y * (1.5f - hv * y * y);
+    y = y * (1.5f - hv * y * y);
+    return v * y;
+}
+
+
+// atan2 using Abramowitz and Stegun 4.4.49 (error < 2e-8 on [0, 1]).
+// Quadrant corrections are arithmetic rather than conditional because
+// compilers will not vectorize conditional floating point expressions.
+static inline float pv_atan2f(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    int swap = isgreater(ay, ax);
+    float mx = swap ? ay : ax;
+    float mn = swap ? ax : ay;
+    float r = mn / (mx + FLT_MIN);  // FLT_MIN avoids 0/0
+    float r2 = r * r;
+    float a = r * (0.9999993329f + r2 * (-0.3332985605f +
+                   r2 * (0.1994653599f + r2 * (-0.1390853351f +
+                   r2 * (0.0964200441f + r2 * (-0.0559098861f +
+                   r2 * (0.0218612288f + r2 * -0.0040540580f)))))));
+    a += (float) swap * ((float) M_PI_2 - 2 * a);  // a = pi/2 - a
+    a += (float) isless(x, 0.0f) * ((float) M_PI - 2 * a);  // a = pi - a
+    return copysignf(a, y);
+}
+
+
+// sine and cosine of x in [-pi, pi] using Taylor series on [-pi/2, pi/2]
+static inline void pv_sincosf(float x, float *s, float *c)
+{
+    // reflect about +/-pi/2: sin(x) = sin(h), cos(x) = -cos(h)
+    float flip = (float) isgreater(fabsf(x), (float) M_PI_2);
+    float h = x + flip * (copysignf((float) M_PI, x) - 2 * x);
+    float h2 = h * h;
+    *s = h * (1.0f + h2 * (-1.0f / 6 + h2 * (1.0f / 120 +
+              h2 * (-1.0f / 5040 + h2 * (1.0f / 362880 +
+              h2 * (-1.0f / 39916800))))));
+    float ch = 1.0f + h2 * (-0.5f + h2 * (1.0f / 24 + h2 * (-1.0f / 720 +
+               h2 * (1.0f / 40320 + h2 * (-1.0f / 3628800 +
+               h2 * (1.0f / 479001600))))));
+    *c = ch - 2 * flip * ch;
+}
+
+
+// Standard phase vocoder phase advance for every bin: estimate the
+// frequency of each bin from the change in analysis phase over
+// ana_hopsize and advance the synthesis phase by syn_hopsize samples at
+// that frequency. The expected advance of bin i over a hop is
+// TWOPI * i * hopsize / fftsize; we reduce i * hopsize modulo fftsize
+// in integer arithmetic, which is exact and keeps float phases small.
+static void advance_phases(PV *pv, int ana_hopsize, float *syn_phase)
+{
+    int n = pv->fftsize / 2 + 1;
+    unsigned int mask = pv->fftsize - 1;
+    unsigned int syn_hopsize = pv->syn_hopsize;
+    float bin_rad = (float) (TWOPI / pv->fftsize);
+    float hop_ratio = (float) pv->syn_hopsize / ana_hopsize;
+    float *ana_phase = pv->ana_phase;
+    float *pre_ana_phase = pv->pre_ana_phase;
+    float *pre_syn_phase = pv->pre_syn_phase;
+    int i;
+    for (i = 0; i < n; i++) {
+        // deviation from the bin frequency, between -M_PI and +M_PI:
+        float dev = pv_wrapf(ana_phase[i] - pre_ana_phase[i] - bin_rad *
+                             (((unsigned int) i * ana_hopsize) & mask));
+        syn_phase[i] = pv_wrapf(pre_syn_phase[i] + dev * hop_ratio + bin_rad *
+                                (((unsigned int) i * syn_hopsize) & mask));
+    }
+}
+
+
+// PV_MODE_PHASEFIX: assign every bin to a peak in mag (see "PHASE
+// COHERENCE" above) and store the peak index in pv->peak_of
+static void find_peaks(PV *pv)
+{
+    int fftsize = pv->fftsize;
+    float *mag = pv->mag;
+    int *peak_of = pv->peak_of;
+    int i;
+    // we'll start each iteration with prev_min_x set to the lowest bin
+    // that will be assigned to the peak at prev_peak_x. We'll find the
+    // next_min_x and the following next_peak_x and assign the bins.
+    //
+    int prev_peak_x = 0; // index of previous peak
+    float prev_peak_mag; // magnitude of previous peak
+    int prev_min_x = 0; // index of previous local minimum
+    int next_peak_x; // index of peak between prev_min_x and next_min_x
+    float next_peak_mag; // magnitude of next peak
+    int next_min_x; // index of next minimum (after peak_x)
+    float next_min_mag; // magnitude at next_min_x
+    float last_mag = mag[0]; // used in search for peaks
+    float this_mag = mag[1];
+    float next_mag;
+    // decide if we're starting on a peak or a minimum:
+    if (last_mag <= this_mag) { // starting on a minimum
+        // find peak
+        for (i = 1; i < fftsize / 2; i++) {
+            next_mag = mag[i + 1];     // invariant: last_mag <= this_mag
+            if (this_mag > next_mag) { // found peak
+                prev_peak_x = i;
+                prev_peak_mag = this_mag;
+                break;  // invariant: this_mag > next_mag
+            }
+            // invariant: this_mag <= next_mag
+            last_mag = this_mag;
+            this_mag = next_mag;  // invariant: last_mag <= this_mag
+        }
+        if (i >= fftsize / 2) {
+            prev_peak_x = i;
+        }
+    } else { // set up to start loop
+        next_mag = this_mag;  // invariant: last_mag > this_mag
+        this_mag = last_mag;  // invariant: this_mag > next_mag
+        prev_peak_mag = last_mag;
+    }
+    while (prev_min_x <= fftsize / 2) {
+        // invariant: prev_min_x is previous local minimum or 0
+        //        prev_peak_x is first local peak after prev_min_x (or 0)
+        //        last_mag is mag at prev_peak_x - 1
+        //        this_mag is mag at prev_peak_x
+        //        next_mag is mag at prev_peak_x + 1
+        // find next minimum
+        // Note: prev_peak_x might be fftsize/2, so i might be fftsize/2 + 1
+        for (i = prev_peak_x + 1; i < fftsize / 2; i++) {
+            last_mag = this_mag;  // invariant: this_mag > next_mag
+            this_mag = next_mag;  // invariant: last_mag > this_mag
+            next_mag = mag[i + 1];
+            if (this_mag <= next_mag) { // found minimum
+                // here, last_mag at i-1, this_mag at i, next_mag at i+1
+                // and next_mix_x == i
+                break;
+            } // loop invariant: this_mag > next_mag
+        }
+        // invariant: this_mag <= next_mag || i == fftsize/2
+        if (i >= fftsize / 2) { // special case at end of spectrum
+            // no minimum found
+            next_min_x = fftsize / 2 + 1;
+        } else {
+            next_min_x = i; // either we found peak or we set i to fftsize/2
+            next_min_mag = mag[i];
+        } // invariant: this_mag <= next_mag || i == fftsize/2
+        // search for second peak; 
+        for (i = next_min_x + 1; i < fftsize / 2; i++) {
+            last_mag = this_mag; // invariant: this_mag <= next_mag
+            this_mag = next_mag; // invariant: last_mag <= this_mag
+            next_mag = mag[i + 1];
+            if (this_mag > next_mag) { // found peak
+                // here, last_mag at i-1, this_mag at i, next_mag at i+1
+                // and next_peak_x == i
+                break;
+            } // loop invariant: this_mag <= next_mag
+        }
+        next_peak_x = i;
+        
+        // special case if we're at the end:
+        if (i >= fftsize / 2) {
+            if (next_mag < this_mag) {
+                next_peak_x = fftsize / 2 + 1;
+            } else {
+                next_peak_x = fftsize / 2; // this may not be necessary
+                next_peak_mag = mag[next_peak_x];
+            }
+        } else {
+            next_peak_mag = mag[i];
+        }
+        // now we have prev_min, prev_peak, next_min, and next_peak. We
+        // want bins from prev_min to next_min to get the phase shift of
+        // prev_peak. First decide if next_min gets assigned to prev_peak
+        // or next_peak. Assign to the closest peak, but break ties by
+        // picking the largest peak.
+        if (next_min_x - prev_peak_x < next_peak_x - next_min_x) {
+            // closer to prev_peak, so include min with it
+            next_min_x++;
+        } else if ((next_min_x - prev_peak_x == next_peak_x - next_min_x) &&
+                   // equidistant so see if prev_peak_mag > next_peak_mag
+                   (prev_peak_mag > next_peak_mag)) {
+            next_min_x++;
+        }
+        // bins prev_min_x through next_min_x - 1 follow prev_peak_x.
+        // prev_peak_x can be fftsize/2 + 1 when the spectrum ends
+        // without a peak; then use the last bin:
+        int j = (prev_peak_x > fftsize / 2 ? fftsize / 2 : prev_peak_x);
+        for (i = prev_min_x; i < next_min_x; i++) {
+            peak_of[i] = j;
+        }
+        // now get ready for the next iteration
+        prev_min_x = next_min_x;
+        prev_peak_x = next_peak_x;
+        prev_peak_mag = next_peak_mag;
+
+    }
+}
+
+
 void compute_one_frame(PV *pv, int ana_hopsize)
 {
     float *syn_frame = pv->syn_frame;
@@ -648,7 +892,6 @@ void compute_one_frame(PV *pv, int ana_hopsize)
     int syn_hopsize = pv->syn_hopsize;
     float *pre_ana_phase = pv->pre_ana_phase;
     float *pre_syn_phase = pv->pre_syn_phase;
-    float *bin_freq = pv->bin_freq;
     int i;
 //#define SKIP_PHASE_ADJUST
 #ifdef SKIP_PHASE_ADJUST
@@ -672,8 +915,8 @@ void compute_one_frame(PV *pv, int ana_hopsize)
     for (i = 1; i < fftsize / 2; i++) {
         float real = ana_frame[2 * i];
         float imag = ana_frame[2 * i + 1];
-        mag[i] = (float)sqrt(real * real + imag * imag);
-        ana_phase[i] = (float)atan2(imag, real);
+        mag[i] = pv_sqrtf(real * real + imag * imag);
+        ana_phase[i] = pv_atan2f(imag, real);
     }
 #ifdef PV_SINE_TEST
     if (pvst_offset == -1000) pvst_offset = -24;
@@ -695,194 +938,52 @@ void compute_one_frame(PV *pv, int ana_hopsize)
         memcpy(syn_phase, ana_phase, 
                ((fftsize / 2) + 1) * sizeof(*syn_phase));
     } else if (pv->mode == PV_MODE_PHASEFIX) {
-        // we'll start each iteration with prev_min_x set to the lowest bin
-        // that will be assigned to the peak at prev_peak_x. We'll find the
-        // next_min_x and the following next_peak_x. Update the phases.
-        //
-        int prev_peak_x = 0; // index of previous peak
-        float prev_peak_mag; // magnitude of previous peak
-        int prev_min_x = 0; // index of previous local minimum
-        int next_peak_x; // index of peak between prev_min_x and next_min_x
-        float next_peak_mag; // magnitude of next peak
-        int next_min_x; // index of next minimum (after peak_x)
-        float next_min_mag; // magnitude at next_min_x
-        float last_mag = mag[0]; // used in search for peaks
-        float this_mag = mag[1];
-        float next_mag;
-        int i; // loop index
-        // decide if we're starting on a peak or a minimum:
-        if (last_mag <= this_mag) { // starting on a minimum
-            // find peak
-            for (i = 1; i < fftsize / 2; i++) {
-                next_mag = mag[i + 1];     // invariant: last_mag <= this_mag
-                if (this_mag > next_mag) { // found peak
-                    prev_peak_x = i;
-                    prev_peak_mag = this_mag;
-                    break;  // invariant: this_mag > next_mag
-                }
-                // invariant: this_mag <= next_mag
-                last_mag = this_mag;
-                this_mag = next_mag;  // invariant: last_mag <= this_mag
-            }
-            if (i >= fftsize / 2) {
-                prev_peak_x = i;
-            }
-        } else { // set up to start loop
-            next_mag = this_mag;  // invariant: last_mag > this_mag
-            this_mag = last_mag;  // invariant: this_mag > next_mag
-            prev_peak_mag = last_mag;
-        }
-        while (prev_min_x <= fftsize / 2) {
-            // invariant: prev_min_x is previous local minimum or 0
-            //        prev_peak_x is first local peak after prev_min_x (or 0)
-            //        last_mag is mag at prev_peak_x - 1
-            //        this_mag is mag at prev_peak_x
-            //        next_mag is mag at prev_peak_x + 1
-            // find next minimum
-            // Note: prev_peak_x might be fftsize/2, so i might be fftsize/2 + 1
-            for (i = prev_peak_x + 1; i < fftsize / 2; i++) {
-                last_mag = this_mag;  // invariant: this_mag > next_mag
-                this_mag = next_mag;  // invariant: last_mag > this_mag
-                next_mag = mag[i + 1];
-                if (this_mag <= next_mag) { // found minimum
-                    // here, last_mag at i-1, this_mag at i, next_mag at i+1
-                    // and next_mix_x == i
-                    break;
-                } // loop invariant: this_mag > next_mag
+        // Each bin gets the phase advance of its peak: the synthesis
+        // phase of bin i is ana_phase[i] + advance[j] - ana_phase[j],
+        // where j = peak_of[i] and advance[j] is the synthesis phase
+        // that the standard phase vocoder computes for bin j.
+        // A linked PV rotates its bins by the leader's rotation of the
+        // leader's peaks, so both channels get the same phase changes
+        // and their phase differences are kept.
+        PV *leader = (PV *) pv->leader;
+        if (leader && leader->mode == PV_MODE_PHASEFIX &&
+            leader->fftsize == fftsize && !leader->first_time) {
+            float *advance = leader->advance;
+            int *peak_of = leader->peak_of;
+            float *lead_phase = leader->ana_phase;
+            for (i = 0; i <= fftsize / 2; i++) {
+                int j = peak_of[i];
+                syn_phase[i] = pv_wrapf(ana_phase[i] + advance[j] -
+                                        lead_phase[j]);
             }
-            // invariant: this_mag <= next_mag || i == fftsize/2
-            if (i >= fftsize / 2) { // special case at end of spectrum
-                // no minimum found
-                next_min_x = fftsize / 2 + 1;
-            } else {
-                next_min_x = i; // either we found peak or we set i to fftsize/2
-                next_min_mag = mag[i];
-            } // invariant: this_mag <= next_mag || i == fftsize/2
-            // search for second peak; 
-            for (i = next_min_x + 1; i < fftsize / 2; i++) {
-                last_mag = this_mag; // invariant: this_mag <= next_mag
-                this_mag = next_mag; // invariant: last_mag <= this_mag
-                next_mag = mag[i + 1];
-                if (this_mag > next_mag) { // found peak
-                    // here, last_mag at i-1, this_mag at i, next_mag at i+1
-                    // and next_peak_x == i
-                    break;
-                } // loop invariant: this_mag <= next_mag
-            }
-            next_peak_x = i;
-            
-            // special case if we're at the end:
-            if (i >= fftsize / 2) {
-                if (next_mag < this_mag) {
-                    next_peak_x = fftsize / 2 + 1;
-                } else {
-                    next_peak_x = fftsize / 2; // this may not be necessary
-                    next_peak_mag = mag[next_peak_x];
-                }
-            } else {
-                next_peak_mag = mag[i];
-            }
-            // now we have prev_min, prev_peak, next_min, and next_peak. We
-            // want bins from prev_min to next_min to get the phase shift of
-            // prev_peak. First decide if next_min gets assigned to prev_peak
-            // or next_peak. Assign to the closest peak, but break ties by
-            // picking the largest peak.
-            if (next_min_x - prev_peak_x < next_peak_x - next_min_x) {
-                // closer to prev_peak, so include min with it
-                next_min_x++;
-            } else if ((next_min_x - prev_peak_x == next_peak_x - next_min_x) &&
-                       // equidistant so see if prev_peak_mag > next_peak_mag
-                       (prev_peak_mag > next_peak_mag)) {
-                next_min_x++;
-            }
-            // Now we want to adjust phases of prev_min_x, prev_min_x + 1, 
-            //   prev_min_x + 2, ..., next_min_x - 1.
-            //
-            // Assign the new phases according to the peak...
-            // increment between actual phase increment value
-            // and the phase increment value got when the
-            // it's the nearest bin frequency. Used
-            // in phase unwrapping:
-            int j = prev_peak_x; // just to make more concise notation
-
-            double phase_increment = ana_phase[j] - pre_ana_phase[j] -
-                                     bin_freq[j] * ana_hopsize;
-            // need to get phase_increment between -M_PI and +M_PI.
-            // Algorithm: add M_PI, get phase_increment between 0 and TWO_PI,
-            // then subtract M_PI:
-            phase_increment = fmod(phase_increment + M_PI, TWOPI);
-            if (phase_increment < 0)
-                phase_increment += TWOPI;
-            phase_increment -= M_PI;
-            // estimated frequency from phase unwrapping
-            /*DBG
-            if (j == 8)
-                printf("phase_increment %g hopsize %d\n", phase_increment, ana_hopsize);
-            DBG*/
-            float estimate_freq = (float) (phase_increment / ana_hopsize +
-                                           bin_freq[j]);
-            // get synthesis phase adjustment
-            phase_increment = pre_syn_phase[j] + 
-                syn_hopsize * estimate_freq - ana_phase[j];
-            /*DBG
-            if (j == 8)
-                printf("phase_increment at %d is %g, freq %g ", j, phase_increment,
-                       estimate_freq);
-            DBG*/
-            // update the range of bins:
-            for (i = prev_min_x; i < next_min_x; i++) {
-                syn_phase[i] = fmodf((float) (ana_phase[i] + phase_increment),
-                                     (float) TWOPI);
+        } else {
+            float *advance = pv->advance;
+            int *peak_of = pv->peak_of;
+            advance_phases(pv, ana_hopsize, advance);
+            find_peaks(pv);
+            for (i = 0; i <= fftsize / 2; i++) {
+                int j = peak_of[i];
+                syn_phase[i] = pv_wrapf(ana_phase[i] + advance[j] -
+                                        ana_phase[j]);
             }
-            /*DBG
-            if (j == 8) printf("syn_phase[8] %g\n", syn_phase[8]);
-            DBG*/
-            // now get ready for the next iteration
-            prev_min_x = next_min_x;
-            prev_peak_x = next_peak_x;
-            prev_peak_mag = next_peak_mag;
-
         }
     } else if (pv->mode == PV_MODE_STANDARD) {
-        for (i = 0; i <= fftsize / 2; i++) {
-            // increment between actual phase increment value
-            // and the phase increment value got when the
-            // it's the nearest bin frequency. Used
-            // in phase unwrapping:
-            double phase_increment = ana_phase[i] - pre_ana_phase[i] -
-                                     bin_freq[i] * ana_hopsize;
-            // need to get phase_increment between -M_PI and +M_PI.
-            // Algorithm: add M_PI, get phase_increment between 0 and TWO_PI,
-            // then subtract M_PI:
-            phase_increment = fmod(phase_increment + M_PI, TWOPI);
-            if (phase_increment < 0)
-                phase_increment += TWOPI;
-            phase_increment -= M_PI;
-
-            // estimated frequency from phase unwrapping
-            float estimate_freq = (float) (phase_increment / ana_hopsize +
-                                           bin_freq[i]);
-            // set synthesis phase
-            syn_phase[i] = fmodf((float) (pre_syn_phase[i] +
-                                          syn_hopsize * estimate_freq),
-                                 (float) TWOPI);
-        }
+        advance_phases(pv, ana_hopsize, syn_phase);
     } else if (pv->mode == PV_MODE_ROBOVOICE) {
         ; // syn_phase[] is unmodified, i.e. constant
     } else {
         assert(FALSE); // bad mode value
     }
+    // record phases
+    memcpy(pre_ana_phase, ana_phase, ((fftsize / 2) + 1) * sizeof(float));
+    memcpy(pre_syn_phase, syn_phase, ((fftsize / 2) + 1) * sizeof(float));
     for (i = 0; i < fftsize / 2; i++) {
-        // record phases
-        pre_ana_phase[i] = ana_phase[i];
-        pre_syn_phase[i] = syn_phase[i];
-        
         // update realpart and imagpart
-        syn_frame[i * 2] = (float) (mag[i] * cos(syn_phase[i]));
-        syn_frame[i * 2 + 1] = (float) (mag[i] * sin(syn_phase[i]));
+        float s, c;
+        pv_sincosf(syn_phase[i], &s, &c);
+        syn_frame[i * 2] = mag[i] * c;
+        syn_frame[i * 2 + 1] = mag[i] * s;
     }
-    pre_ana_phase[i] = ana_phase[i];
-    pre_syn_phase[i] = syn_phase[i];
     // update realpart and imagpart
     syn_frame[1] = (float) (mag[i] * cos(syn_phase[i]));
      // inverse FFT
@@ -127,6 +127,17 @@ void pv_set_syn_window(Phase_vocoder x, float *window);
 //   illegal mode values are ignored
 void pv_set_mode(Phase_vocoder x, int mode);
 
+// link x to leader for PV_MODE_PHASEFIX: x assigns bins to spectral
+//   peaks found by leader instead of searching its own spectrum, and
+//   rotates each bin by the phase change leader applies to its peak,
+//   so linked channels (e.g. left and right of a stereo signal) share
+//   one phase-locking pass and keep their phase relationships. Each frame
+//   of leader must be computed before the corresponding frame of x,
+//   both must have the same fftsize, and leader must be in
+//   PV_MODE_PHASEFIX (otherwise x finds its own peaks). Pass NULL to
+//   unlink. leader must not be freed while x is linked to it.
+void pv_set_link(Phase_vocoder x, Phase_vocoder leader);
+
 // allocate a window and initialize it with the window_type function
 // (see hann() and hamm() as example window_type functions)
 // caller becomes the owner of the result, so the owner should free
@@ -3,9 +3,32 @@
  * Roger B. Dannenberg
  */
 
+#ifndef RESAMP_H
+#define RESAMP_H
+
 /* perform windowed sinc interpolation.
  */
 
+/* Polyphase mode: interp() evaluates the windowed sinc at every tap of
+ * every output sample. With polyphase set (the default), resamp()
+ * instead uses a bank of precomputed coefficient rows, one for each
+ * of phases fractional offsets from 0 to 1 (plus one for offset 1).
+ * An output sample is a dot product of the input with the row for its
+ * fractional offset, linearly interpolated with the next row if the
+ * offset falls between rows. The dot products are written to
+ * vectorize. The bank is rebuilt when scale changes or a new period
+ * needs a different number of phases. Rebuilding allocates unless
+ * reserve_bank() was called with the largest scale to be used, so
+ * real-time callers should call it first.
+ *
+ * When period is a rational n / d with d <= RESAMP_MAX_PHASES, phases
+ * is a multiple of d, so after starting on a row (e.g. an integer
+ * offset), every output sample lands exactly on a row and needs only
+ * one dot product. Otherwise phases = ov, and with scale = 1,
+ * interpolating between rows gives the same result as interp().
+ */
+#define RESAMP_MAX_PHASES 64
+
 typedef float rsfloat;
 
 struct Sinc_point {
@@ -21,6 +44,13 @@ class Resamp {
     int ov;    // how fine the span is oversampled to (span * ov) + 1 points
                // only (span / 2 * ov) are stored making use of symmetry.
     Vec<Sinc_point> sinc; // points for the windowed sinc function.
+
+    bool polyphase;  // use bank in resamp() (see above)
+    rsfloat bank_scale;  // the scale and period bank was built for
+    double bank_period;
+    int taps;    // coefficients per row: 2 * ceil(span * scale / 2)
+    int phases;  // bank has phases + 1 rows of taps coefficients
+    Vec<float> bank;
     
     Resamp() {  // you must initialize a Resamp with span and ov(ersampling)
     }
@@ -28,6 +58,11 @@ class Resamp {
     void init(int span_, int ov_) {
         span = span_;
         ov = ov_;
+        polyphase = true;
+        bank_scale = 0;  // no bank yet
+        bank_period = 0;
+        taps = 0;
+        phases = 0;
         int m = (span / 2) * ov + 1;
         sinc.set_size(m + 1, false);
         for (int i = 0; i <= m; i++) {
@@ -51,6 +86,103 @@ class Resamp {
     
     void finish() {
         sinc.finish();
+        bank.finish();
+    }
+
+
+    void set_polyphase(bool p) { polyphase = p; }
+
+
+    // windowed sinc at table position d (distance * ov / scale), with
+    // the same interpolation between stored points as interp():
+    float weight(rsfloat d) {
+        int j = (int) d;
+        if (d > (span / 2) * ov) {
+            return 0;  // beyond the window
+        }
+        Sinc_point &sp = sinc[j];
+        return sp.sinc + (d - j) * sp.dsinc;
+    }
+
+
+    // the number of phases in the bank for period (see above)
+    int phases_for(double period) {
+        for (int d = 1; d <= RESAMP_MAX_PHASES; d++) {
+            double n = period * d;
+            if (fabs(n - std::round(n)) < 1e-5) {  // period is n / d
+                return d * ((ov + d - 1) / d);  // multiple of d >= ov
+            }
+        }
+        return ov;
+    }
+
+
+    // allocate the bank for scales up to max_scale so that build_bank()
+    // does not allocate. phases_for() is at most
+    // MAX(2 * ov - 1, RESAMP_MAX_PHASES).
+    void reserve_bank(rsfloat max_scale) {
+        int max_taps = 2 * (int) std::ceil(max_scale * (span / 2));
+        int max_phases = MAX(2 * ov, RESAMP_MAX_PHASES);
+        bank.set_size((max_phases + 1) * max_taps, false);
+    }
+
+
+    // compute the polyphase bank for scale and period. Row p holds
+    // weights for output at fractional offset p / phases, with tap k
+    // at input floor(offset) - taps / 2 + 1 + k. Weights include the
+    // 1 / scale gain of resamp().
+    void build_bank(rsfloat scale, double period) {
+        bank_scale = scale;
+        bank_period = period;
+        phases = phases_for(period);
+        int h = (int) std::ceil(scale * (span / 2));
+        taps = 2 * h;
+        bank.set_size((phases + 1) * taps, false);
+        rsfloat d_inc = ov / scale;
+        for (int p = 0; p <= phases; p++) {
+            double frac = (double) p / phases;
+            float *row = &bank[p * taps];
+            for (int k = 0; k < taps; k++) {
+                rsfloat x = (rsfloat) fabs(k - h + 1 - frac);
+                row[k] = weight(x * d_inc) / scale;
+            }
+        }
+    }
+
+
+    // dot product of n coefficients and input, with 4 partial sums so
+    // that the loop vectorizes without reassociating a single sum:
+    static float dot(const float *coef, const float *input, int n) {
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        int i = 0;
+        for ( ; i + 4 <= n; i += 4) {
+            s0 += coef[i] * input[i];
+            s1 += coef[i + 1] * input[i + 1];
+            s2 += coef[i + 2] * input[i + 2];
+            s3 += coef[i + 3] * input[i + 3];
+        }
+        for ( ; i < n; i++) {
+            s0 += coef[i] * input[i];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+
+    // like dot() but coefficients are interpolated between c0 and c1:
+    static float dot2(const float *c0, const float *c1, float frac,
+                      const float *input, int n) {
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        int i = 0;
+        for ( ; i + 4 <= n; i += 4) {
+            s0 += (c0[i] + frac * (c1[i] - c0[i])) * input[i];
+            s1 += (c0[i + 1] + frac * (c1[i + 1] - c0[i + 1])) * input[i + 1];
+            s2 += (c0[i + 2] + frac * (c1[i + 2] - c0[i + 2])) * input[i + 2];
+            s3 += (c0[i + 3] + frac * (c1[i + 3] - c0[i + 3])) * input[i + 3];
+        }
+        for ( ; i < n; i++) {
+            s0 += (c0[i] + frac * (c1[i] - c0[i])) * input[i];
+        }
+        return (s0 + s1) + (s2 + s3);
     }
 
     
@@ -108,11 +240,55 @@ class Resamp {
     // than a perceptual difference.
     void resamp(Sample_ptr output, int len, Sample_ptr input, double offset,
                 rsfloat scale, double period) {
+        if (polyphase) {
+            resamp_bank(output, len, input, offset, scale, period);
+            return;
+        }
         rsfloat scale_inverse = 1.0 / scale;
         for (int i = 0; i < len; i++) {
             *output++ = interp(input, offset, scale) * scale_inverse;
             offset += period;
         }
     }
+
+
+    // resamp() using the polyphase bank. Taps are limited to the input
+    // range that interp() reads, floor(offset -/+ span * scale / 2), so
+    // this never reads beyond the samples that interp() would use.
+    void resamp_bank(Sample_ptr output, int len, Sample_ptr input,
+                     double offset, rsfloat scale, double period) {
+        if (scale != bank_scale) {
+            build_bank(scale, period);
+        } else if (period != bank_period) {
+            // the rows depend only on scale and phases, so a new period
+            // (e.g. from a speed change with scale 1) can often keep them
+            if (phases_for(period) != phases) {
+                build_bank(scale, period);
+            }
+            bank_period = period;
+        }
+        double half = scale * (span / 2);
+        int h = taps / 2;
+        for (int i = 0; i < len; i++) {
+            double n0 = std::floor(offset);
+            double pos = (offset - n0) * phases;
+            int p = (int) pos;
+            float frac = (float) (pos - p);
+            int base = (int) n0 - h + 1;  // input index of tap 0
+            int k0 = MAX((int) std::ceil(offset - half) - base, 0);
+            int k1 = MIN((int) std::floor(offset + half) - base + 1, taps);
+            const float *row = &bank[p * taps];
+            const float *in = input + base + k0;
+            if (frac < 1e-4f) {  // on a row
+                *output++ = dot(row + k0, in, k1 - k0);
+            } else if (frac > 1 - 1e-4f) {  // on the next row
+                *output++ = dot(row + taps + k0, in, k1 - k0);
+            } else {
+                *output++ = dot2(row + k0, row + taps + k0, frac, in, k1 - k0);
+            }
+            offset += period;
+        }
+    }
 };
 
+#endif
@@ -8,21 +8,30 @@
 #include "ffts_compat.h"
 #include "pffft.h"
 #include "assert.h"
+#include <atomic>
 
-static PFFFT_Setup *pffft_setups[32] = {0, 0, 0, 0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0, 0, 0, 0,
-                                        0, 0, 0, 0, 0, 0, 0, 0};
+// Setups are shared by threads (e.g. a main-thread job may create one
+// that the audio thread then uses), so each is published with release
+// ordering and read with acquire ordering; static storage makes them
+// all initially NULL.
+static std::atomic<PFFFT_Setup *> pffft_setups[32];
 
 
 /* prepare to FFT with log(fft size) == M
    returns 1 for success, 2 for fail
+   Safe to call from more than one thread: if two threads create a
+   setup for M at once, one is kept and the other is destroyed.
  */
 int fftInit(long M)
 {
     if ((M >= 0) && (M < 32)) {
-        if (!pffft_setups[M]) {
-            pffft_setups[M] = pffft_new_setup(1 << M, PFFFT_REAL);
+        if (!pffft_setups[M].load(std::memory_order_acquire)) {
+            PFFFT_Setup *setup = pffft_new_setup(1 << M, PFFFT_REAL);
+            PFFFT_Setup *expected = NULL;
+            if (!pffft_setups[M].compare_exchange_strong(expected, setup,
+                        std::memory_order_acq_rel)) {
+                pffft_destroy_setup(setup);  // another thread won
+            }
         }
         return 1;
     }
@@ -35,9 +44,9 @@ int fftInit(long M)
 void fftFree(void)
 {
     for (int i = 0; i < 32; i++) {
-        if (pffft_setups[i]) {
-            pffft_destroy_setup(pffft_setups[i]);
-            pffft_setups[i] = NULL;
+        PFFFT_Setup *setup = pffft_setups[i].exchange(NULL);
+        if (setup) {
+            pffft_destroy_setup(setup);
         }
     }
 }
@@ -47,8 +56,13 @@ void fftFree(void)
  */
 void rffts(float *data, long M, long Rows)
 {
+    PFFFT_Setup *setup = pffft_setups[M].load(std::memory_order_acquire);
     float *work = (M < 14 ? NULL : O2_MALLOCNT(1 << M, float));
-    pffft_transform_ordered(pffft_setups[M], data, data, work, PFFFT_FORWARD);
+    for (long row = 0; row < Rows; row++) {  // rows are contiguous
+        float *ptr = data + (row << M);
+        pffft_transform_ordered(setup, ptr, ptr, work,
+                                PFFFT_FORWARD);
+    }
     if (work) {
         O2_FREE(work);
     }
@@ -61,11 +75,16 @@ void riffts(float *data, long M, long Rows)
 {
     int N = 1 << M;
     float Nrecip = 1.0 / N;
+    PFFFT_Setup *setup = pffft_setups[M].load(std::memory_order_acquire);
     float *work = (M < 14 ? NULL : O2_MALLOCNT(N, float));
-    pffft_transform_ordered(pffft_setups[M], data, data, work, PFFFT_BACKWARD);
-    // result is not scaled by 1/N yet:
-    for (int i = 0; i < N; i++) {
-        data[i] *= Nrecip;
+    for (long row = 0; row < Rows; row++) {  // rows are contiguous
+        float *ptr = data + (row << M);
+        pffft_transform_ordered(setup, ptr, ptr, work,
+                                PFFFT_BACKWARD);
+        // result is not scaled by 1/N yet:
+        for (int i = 0; i < N; i++) {
+            ptr[i] *= Nrecip;
+        }
     }
     if (work) {
         O2_FREE(work);
@@ -45,7 +45,8 @@ NONFAUST = ["thru", "zero", "zerob", "vu", "probe", "pwl", "pwlb", "delay",
             "mathugenb", "unaryugen", "unaryugenb", "onset", "chorddetect",
             "o2audioio", "spectralcentroid", "spectralrolloff", "tableosc",
             "tableoscb", "stdistr", "blend", "blendb", "upsample", "delayvi",
-            "multisend"]
+            "multisend", "unison", "multitap", "shmtap", "meter",
+            "featurevec", "multionset"]
 
 MATHUGENS = ["mult", "add", "sub", "ugen_div", "ugen_max", "ugen_min",
              "ugen_clip", "ugen_pow", "ugen_less", "ugen_greater",
@@ -353,6 +354,7 @@ def make_inclfile(arco_path, manifest, outf):
                             # (for o2audioio)
     need_wavetables = False  # need to compile and link with wavetables.{cpp,h}
     need_monodistortion = False  # need to compile and link with monodistortion
+    need_speckernel = False  # need to compile and link with speckernel.{cpp,h}
     
     # "standard" for Serpent GUI are vu, probe, and filerec:
     if "filerec" not in manifest:
@@ -411,7 +413,8 @@ def make_inclfile(arco_path, manifest, outf):
     if ("o2audioio" in manifest):
         need_audioblob = True
 
-    if "onset" in manifest:  # add modal implementation files
+    if "onset" in manifest or "multionset" in manifest:
+        # add modal implementation files
         df_path = arco_path + "/modal/modal/detectionfunctions/"
         print("    " + df_path + "detectionfunctions.cpp",
                       df_path + "detectionfunctions.h\n",
@@ -430,13 +433,15 @@ def make_inclfile(arco_path, manifest, outf):
     
     if "spectralcentroid" in manifest:  # add FFTCalculator implementation files
         need_fft = True
+        need_speckernel = True
     
     if "spectralrolloff" in manifest:  # add FFTCalculator implementation files
         need_fft = True
 
     if ("tableosc" in manifest or "tableoscb" in manifest or
-        "tableosc*" in manifest):
+        "tableosc*" in manifest or "unison" in manifest):
         need_wavetables = True
+        need_fft = True  # wavetables are built with an inverse FFT
 
 
     ## Include source files to satisfy dependencies
@@ -475,6 +480,9 @@ def make_inclfile(arco_path, manifest, outf):
     if need_wavetables:
         print("    src/wavetables.cpp src/wavetables.h", file=outf)
 
+    if need_speckernel:
+        print("    src/speckernel.cpp src/speckernel.h", file=outf)
+
 
     ## Add source files for specified ugens
     print("Adding these unit generator implementations to the executable:")
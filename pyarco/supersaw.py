@@ -6,13 +6,11 @@ _sawtooth_waveforms = None
 
 
 class Sawtooth_waveforms:
-    """Singleton manager for anti-aliased sawtooth wavetables."""
+    """Singleton manager for sawtooth wavetables in the wavetable bank."""
 
     def __init__(self):
         global _sawtooth_waveforms
         self.created = [None] * 36
-        self.tables = Tableosc(1, 1)
-        self.next_index = 0
         _sawtooth_waveforms = self
 
     def get_index(self, step, antialias=True):
@@ -22,20 +20,20 @@ class Sawtooth_waveforms:
             i = 0
         if self.created[i] is not None:
             return self.created[i]
-        self.created[i] = self.next_index
+        index = wtbank_handle(f"sawtooth{i}")
+        self.created[i] = index
 
         if antialias:
             f0 = step_to_hz(step)
             n = max(1, int(AR * 2 / (5 * f0)))
             tlen = max(16 * n, 512)
             ampspec = [1 / (j + 1) for j in range(n)]
-            self.tables.create_tas(self.next_index, tlen, ampspec)
+            wtbank_create_tas(index, tlen, ampspec)
         else:
             ampspec = [i / 256 for i in range(256)]
-            self.tables.create_ttd(self.next_index, ampspec)
+            wtbank_create_ttd(index, ampspec)
 
-        self.next_index += 1
-        return self.next_index - 1
+        return index
 
 
 class Supersaw_instr(Instrument):
@@ -127,7 +125,7 @@ class Supersaw_instr(Instrument):
         amp = self._calc_tableosc_amp(i)
         phase = rndphase * random.uniform(0, 360)
         comp = Tableosc(hz, Const(amp), phase=phase)
-        comp.borrow(_sawtooth_waveforms.tables)
+        comp.use_bank()
         comp.select(table_index)
 
         if chans == 1:
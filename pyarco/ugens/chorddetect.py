@@ -15,6 +15,11 @@ class Chorddetect(Ugen):
                         reply_addr)
         return self
 
+    def hop(self, samples):
+        o2lite.send_cmd("/arco/chorddetect/hop", 0, "ii", self.arco_ref(),
+                        samples)
+        return self
+
 
 def chorddetect(input, reply_addr):
     return Chorddetect(input, reply_addr)
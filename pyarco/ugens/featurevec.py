@@ -0,0 +1,37 @@
+from pyarco.arco_ugens import *
+
+# featurevec.py -- collect analysis results into one vector per frame
+# Output (b-rate) the latest results of analysis ugens (yin, onset,
+# spectralcentroid, spectralrolloff, chorddetect), one channel per
+# value in the order inserted, and if reply_addr is not "", send id,
+# time and all values in one message whenever any source has a new
+# frame. Call run() if the output is not otherwise used.
+
+class Featurevec(Ugen):
+
+    def __init__(self, chans, reply_addr):
+        super().__init__(new_ugen_id(), "Featurevec", chans, B_RATE, "s",
+                         None, None, 'reply_addr', reply_addr, "s")
+
+    def ins(self, *sources):
+        for source in sources:
+            self.inputs[source.arco_ref()] = source
+            o2lite.send_cmd("/arco/featurevec/ins", 0, "ii",
+                            self.arco_ref(), source.arco_ref())
+        return self
+
+    def rem(self, *sources):
+        for source in sources:
+            if self.inputs.pop(source.arco_ref(), None):
+                o2lite.send_cmd("/arco/featurevec/rem", 0, "ii",
+                                self.arco_ref(), source.arco_ref())
+        return self
+
+    def start(self, reply_addr):
+        o2lite.send_cmd("/arco/featurevec/start", 0, "is",
+                        self.arco_ref(), reply_addr)
+        return self
+
+
+def featurevec(chans, reply_addr=""):
+    return Featurevec(chans, reply_addr)
@@ -7,6 +7,14 @@ def fileplay(filename, chans=2, start=0, end=0,
     return Fileplay(chans, filename, start, end, cycle, mix, expand)
 
 
+def fileplay_prime(filename, dur=0.25):
+    o2lite.send_cmd("/arco/fileplay/prime", 0, "sf", filename, dur)
+
+
+def fileplay_unprime(filename):
+    o2lite.send_cmd("/arco/fileplay/unprime", 0, "s", filename)
+
+
 class Fileplay(Ugen):
 
     def __init__(self, chans, filename, start, end, cycle, mix, expand):
@@ -25,3 +33,13 @@ class Fileplay(Ugen):
 
     def stop(self):
         return self.start(False)
+
+    def set_speed(self, speed):
+        o2lite.send_cmd("/arco/fileplay/speed", 0, "if",
+                        self.arco_ref(), speed)
+        return self
+
+    def stats(self, reply_addr):
+        o2lite.send_cmd("/arco/fileplay/stats", 0, "is",
+                        self.arco_ref(), reply_addr)
+        return self
@@ -57,6 +57,11 @@ class Granstream(Ugen):
                         self.arco_ref(), fb)
         return self
 
+    def set_budget(self, max_grains):
+        o2lite.send_cmd("/arco/granstream/budget", 0, "ii",
+                        self.arco_ref(), max_grains)
+        return self
+
 
 def granstream(input, polyphony, dur, enable, chans=1):
     Granstream(chans, input, polyphony, dur, enable)
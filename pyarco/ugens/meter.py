@@ -0,0 +1,27 @@
+from pyarco.arco_ugens import *
+
+# meter.py -- multichannel peak, RMS, true-peak and loudness meter
+# Every period, Arco sends one message to reply_addr with id, then
+# peak, rms, true peak and loudness (LUFS) for each input channel.
+
+def meter(reply_addr, period):
+    return Meter(reply_addr, period)
+
+
+class Meter(Ugen):
+
+    def __init__(self, reply_addr, period):
+        super().__init__(new_ugen_id(), "Meter", 0, '', "sf", None, None,
+                         'reply_addr', reply_addr, "s",
+                         'period', period, "f")
+
+    def start(self, reply_addr, period):
+        o2lite.send_cmd("/arco/meter/start", 0, "isf", self.arco_ref(),
+                        reply_addr, period)
+        return self
+
+    def set(self, input_name, value):
+        self.inputs['input'] = value
+        o2lite.send_cmd("/arco/meter/repl_input", 0, "ii",
+                        self.arco_ref(), value.arco_ref())
+        return self
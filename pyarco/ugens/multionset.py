@@ -0,0 +1,19 @@
+from pyarco.arco_ugens import *
+
+# multionset.py -- batched multichannel onset detection
+# Like Onset, sends id, channel to reply_addr for each onset in any
+# channel of input. frame_size is a power of 2 and hop_size is a
+# multiple of 32 (Onset uses 256 and 128).
+
+class Multionset(Ugen):
+
+    def __init__(self, input, reply_addr, frame_size, hop_size):
+        super().__init__(new_ugen_id(), "Multionset", 0, NO_RATE, "Usii",
+                         None, True, 'input', input, "a",
+                         'reply_addr', reply_addr, "s",
+                         'frame_size', frame_size, "i",
+                         'hop_size', hop_size, "i")
+
+
+def multionset(input, reply_addr, frame_size=256, hop_size=128):
+    return Multionset(input, reply_addr, frame_size, hop_size)
@@ -0,0 +1,46 @@
+from pyarco.arco_ugens import *
+
+# multitap.py -- multi-tap fractional delay
+# One delay line per channel read by ntaps fractional, modulated taps.
+
+class Multitap(Ugen):
+
+    def __init__(self, chans, input, maxdur, ntaps):
+        super().__init__(new_ugen_id(), "Multitap", chans, A_RATE,
+                         "Ufi", None, None,
+                         'input', input, "a", 'maxdur', maxdur, "f",
+                         'ntaps', ntaps, "i")
+
+    def tap(self, index, dur, gain):
+        # Set the delay (a Ugen or number, in seconds) and gain of a tap
+        if isinstance(dur, (int, float, list)):
+            dur = Const(dur)
+        self.inputs["tap" + str(index)] = dur  # retain the ugen
+        o2lite.send_cmd("/arco/multitap/tap", 0, "iiif", self.arco_ref(),
+                        index, dur.arco_ref(), gain)
+        return self
+
+    def set_dur(self, index, dur, chan=0):
+        # Set the delay of a tap. If the delay is a Const, set its value
+        previous = self.inputs.get("tap" + str(index))
+        if (isinstance(dur, (int, float)) and previous and
+            previous.rate == C_RATE):
+            o2lite.send_cmd("/arco/multitap/set_dur", 0, "iiif",
+                            self.arco_ref(), index, chan, dur)
+        else:
+            if isinstance(dur, (int, float, list)):
+                dur = Const(dur)
+            self.inputs["tap" + str(index)] = dur
+            o2lite.send_cmd("/arco/multitap/repl_dur", 0, "iii",
+                            self.arco_ref(), index, dur.arco_ref())
+        return self
+
+    def set_gain(self, index, gain):
+        o2lite.send_cmd("/arco/multitap/gain", 0, "iif", self.arco_ref(),
+                        index, gain)
+        return self
+
+
+def multitap(input, maxdur, ntaps, chans=None):
+    chans = max_chans(chans, input)
+    return Multitap(chans, input, maxdur, ntaps)
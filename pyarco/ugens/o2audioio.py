@@ -22,6 +22,23 @@ class O2audioio(Ugen):
         o2_send_cmd("/arco/o2aud/enab", 0, "Ui", id, value)
         return self
 
+    def set_drift(self, flag):
+        # enable compensation for a sender with its own audio clock
+        o2lite.send_cmd("/arco/o2aud/drift", 0, "iB", self.arco_ref(), flag)
+        return self
+
+    def set_adapt(self, flag, min_frames, max_frames):
+        # let latency follow network jitter between min_frames and max_frames
+        o2lite.send_cmd("/arco/o2aud/adapt", 0, "iBii", self.arco_ref(),
+                        flag, min_frames, max_frames)
+        return self
+
+    def stats(self, reply_addr):
+        # request statistics, sent to reply_addr with types "iiifiB"
+        o2lite.send_cmd("/arco/o2aud/stats", 0, "is", self.arco_ref(),
+                        reply_addr)
+        return self
+
 
 def o2audioio(input, destaddr, destchans, recvchans, buffsize,
               sampletype, msgsize)
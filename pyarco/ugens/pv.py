@@ -20,5 +20,9 @@ class Pv(Ugen):
         o2lite.send_cmd("/arco/pv/stretch", 0, "if", self.arco_ref(), value)
         return self
 
+    def set_linked(self, flag):
+        o2lite.send_cmd("/arco/pv/linked", 0, "iB", self.arco_ref(), flag)
+        return self
+
 def pv(input, ratio, fftsize, hopsize, points, mode, chans=1):
     Pv(chans, input, ratio, fftsize, hopsize, points, mode)
@@ -36,3 +36,7 @@ class Recplay(Ugen):
     def borrow(self, u):
         o2lite.send_cmd("/arco/recplay/borrow", 0, "ii", self.arco_ref(), u.id)
         return self
+
+    def spill(self, flag):
+        o2lite.send_cmd("/arco/recplay/spill", 0, "iB", self.arco_ref(), flag)
+        return self
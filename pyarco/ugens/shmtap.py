@@ -0,0 +1,105 @@
+from pyarco.arco_ugens import *
+import os
+import struct
+from multiprocessing import shared_memory, resource_tracker
+
+# shmtap.py -- write signals to a shared memory ring for local clients
+# Shmtap runs in Arco; Shmtap_reader maps the ring in this process.
+
+SHMTAP_MAGIC = 0x41524354
+SHMTAP_VERSION = 1
+
+class Shmtap(Ugen):
+
+    def __init__(self, chans, input, first, frames, name):
+        super().__init__(new_ugen_id(), "Shmtap", chans, NO_RATE, "Uiis",
+                         None, None,
+                         'input', input, "ab", 'first', first, "i",
+                         'frames', frames, "i", 'name', name, "s")
+        self.running = False
+        self.start()
+
+    def start(self):  # copy input to the ring every block
+        if not self.running:
+            self.run()
+            self.running = True
+        return self
+
+    def stop(self):  # stop copying; the ring keeps its contents
+        if self.running:
+            self.unrun()
+            self.running = False
+        return self
+
+
+def shmtap(input, name, frames=8192, first=0, chans=None):
+    chans = max_chans(chans, input)
+    return Shmtap(chans, input, first, frames, name)
+
+
+class Shmtap_reader:
+    """Read the most recent frames from a Shmtap ring (see shmtap.h).
+    Arco must be on the same host. The ring may not exist until shortly
+    after the Shmtap is created, so open() returns False until then.
+    """
+
+    def __init__(self, name):
+        self.name = name.lstrip('/')
+        self.shm = None
+
+    def open(self):
+        if self.shm:
+            return True
+        try:
+            try:
+                shm = shared_memory.SharedMemory(name=self.name,
+                                                 track=False)  # 3.13+
+            except TypeError:
+                shm = shared_memory.SharedMemory(name=self.name)
+                if os.name == 'posix':  # do not remove Arco's ring at exit
+                    resource_tracker.unregister(shm._name, 'shared_memory')
+        except FileNotFoundError:
+            return False
+        (magic, version, self.chans, self.frames, self.sample_rate,
+         header_size) = struct.unpack_from('IIiifi', shm.buf, 0)
+        if magic != SHMTAP_MAGIC or version != SHMTAP_VERSION:
+            shm.close()
+            return False
+        self.shm = shm
+        self.samples = shm.buf[header_size:].cast('f')
+        return True
+
+    def close(self):
+        if self.shm:
+            self.samples.release()
+            self.shm.close()
+            self.shm = None
+
+    def write_count(self):
+        return struct.unpack_from('Q', self.shm.buf, 24)[0]
+
+    def read(self, n):
+        """Return (count, channels) where channels is a list of chans
+        lists with the last n frames (n <= frames), and count is the
+        frame count just after the last frame, or None if not open or
+        if the writer overwrote the frames while they were copied.
+        """
+        if not self.open():
+            return None
+        n = min(n, self.frames)
+        w1 = self.write_count()
+        n = min(n, w1)
+        start = (w1 - n) % self.frames
+        channels = []
+        for c in range(self.chans):
+            base = c * self.frames
+            if start + n <= self.frames:
+                x = self.samples[base + start : base + start + n].tolist()
+            else:
+                x = (self.samples[base + start : base + self.frames].tolist() +
+                     self.samples[base : base + start + n - self.frames].tolist())
+            channels.append(x)
+        w2 = self.write_count()
+        if w2 - (w1 - n) > self.frames:
+            return None
+        return (w1, channels)
@@ -42,11 +42,56 @@ class Wavetables(Ugen):
                         lender.id)
         return self
 
+    def use_bank(self):
+        # Play tables from the server-wide wavetable bank (see wtbank_handle)
+        o2lite.send_cmd(f"{self.address_prefix}bank", 0, "i", self.arco_ref())
+        return self
+
     def select(self, index):
         o2lite.send_cmd(f"{self.address_prefix}sel", 0, "ii", self.arco_ref(), index)
         return self
 
 
+# The wavetable bank holds tables in the server that are shared by all
+# Tableosc and Tableoscb instances that call use_bank(). Tables are
+# referenced by index, and wtbank_handle() maps names to indices.
+# The map is kept here, not in the server, so only one client process
+# may create bank tables; another client would allocate the same
+# indices for its own names and overwrite this client's tables.
+_wtbank_handles = {}
+
+
+def wtbank_handle(name):
+    """Get the bank index for name, allocating a new index the first time."""
+    return _wtbank_handles.setdefault(name, len(_wtbank_handles))
+
+
+def _wtbank_create(index, tlen, data, method_name):
+    params = [index]
+    type_str = "i"
+    if tlen is not None:  # omit length for time-domain data
+        params.append(tlen)
+        type_str += "i"
+    params.extend(data)
+    type_str += "f" * len(data)
+    o2lite.send_cmd(f"/arco/wtbank/{method_name}", 0, type_str, *params)
+
+
+def wtbank_create_tas(index, tlen, ampspec):
+    # Create bank table from amplitude spectrum
+    _wtbank_create(index, tlen, ampspec, "createtas")
+
+
+def wtbank_create_tcs(index, tlen, spec):
+    # Create bank table from complex spectrum (amplitude and phase pairs)
+    _wtbank_create(index, tlen, spec, "createtcs")
+
+
+def wtbank_create_ttd(index, samps):
+    # Create bank table from time-domain data (table length is len(samps))
+    _wtbank_create(index, None, samps, "createttd")
+
+
 class Tableosc(Wavetables):
 
     def __init__(self, freq, amp, phase=0, chans=None):
@@ -0,0 +1,31 @@
+from pyarco.arco_ugens import *
+
+# unison.py -- detuned multi-voice table-lookup oscillator
+# Tables come from the wavetable bank (see wtbank_create_tas, etc.)
+
+class Unison(Ugen):
+
+    def __init__(self, chans, voices, freq, detune, amp, rolloff, width):
+        super().__init__(new_ugen_id(), "Unison", chans, A_RATE,
+                         "iUUUff", None, None,
+                         'voices', voices, "i", 'freq', freq, "abc",
+                         'detune', detune, "abc", 'amp', amp, "abc",
+                         'rolloff', rolloff, "f", 'width', width, "f")
+
+    def select(self, index):
+        # Select a table from the wavetable bank
+        o2lite.send_cmd("/arco/unison/sel", 0, "ii", self.arco_ref(), index)
+        return self
+
+    def set_rolloff(self, rolloff):
+        o2lite.send_cmd("/arco/unison/rolloff", 0, "if",
+                        self.arco_ref(), rolloff)
+        return self
+
+    def set_width(self, width):
+        o2lite.send_cmd("/arco/unison/width", 0, "if", self.arco_ref(), width)
+        return self
+
+
+def unison(voices, freq, detune, amp, chans=1, rolloff=1, width=1):
+    return Unison(chans, voices, freq, detune, amp, rolloff, width)
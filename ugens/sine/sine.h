@@ -89,7 +89,7 @@ class Sine : public Ugen {
 public:
     struct Sine_state {
         int iVec1[2];
-        float fRec1[2];
+        uint32_t fRec1[2];  // fixed-point phase, 2^32 is one period
         Sample fSlow0_prev;
         Sample fSlow1_prev;
     };
@@ -143,7 +143,7 @@ public:
                 states[i].iVec1[l2] = 0;
             }
             for (int l3 = 0; l3 < 2; l3 = l3 + 1) {
-                states[i].fRec1[l3] = 0.0f;
+                states[i].fRec1[l3] = 0;
             }
             states[i].fSlow0_prev = 0.0f;
             states[i].fSlow1_prev = 0.0f;
@@ -206,11 +206,8 @@ public:
         FAUSTFLOAT* input1 = amp_samps;
         FAUSTFLOAT* output0 = out_samps;
         for (int i0 = 0; i0 < BL; i0 = i0 + 1) {
-            state->iVec1[0] = 1;
-            float fTemp0 = ((1 - state->iVec1[1]) ? 0.0f : state->fRec1[1] + fConst0 * static_cast<float>(input0[i0]));
-            state->fRec1[0] = fTemp0 - std::floor(fTemp0);
-            output0[i0] = static_cast<FAUSTFLOAT>(static_cast<float>(input1[i0]) * ftbl0SineSIG0[std::max<int>(0, std::min<int>(static_cast<int>(65536.0f * state->fRec1[0]), 65535))]);
-            state->iVec1[1] = state->iVec1[0];
+            state->fRec1[0] = state->fRec1[1] + static_cast<uint32_t>(static_cast<int64_t>(4294967296.0f * (fConst0 * static_cast<float>(input0[i0]))));
+            output0[i0] = static_cast<FAUSTFLOAT>(static_cast<float>(input1[i0]) * ftbl0SineSIG0[(state->fRec1[1] >> 16)]);
             state->fRec1[1] = state->fRec1[0];
         }
     }
@@ -224,11 +221,8 @@ public:
         state->fSlow0_prev = fSlow0;
         for (int i0 = 0; i0 < BL; i0 = i0 + 1) {
             fSlow0_fast += fSlow0_incr;
-            state->iVec1[0] = 1;
-            float fTemp0 = ((1 - state->iVec1[1]) ? 0.0f : state->fRec1[1] + fConst0 * static_cast<float>(input0[i0]));
-            state->fRec1[0] = fTemp0 - std::floor(fTemp0);
-            output0[i0] = static_cast<FAUSTFLOAT>(fSlow0_fast * ftbl0SineSIG0[std::max<int>(0, std::min<int>(static_cast<int>(65536.0f * state->fRec1[0]), 65535))]);
-            state->iVec1[1] = state->iVec1[0];
+            state->fRec1[0] = state->fRec1[1] + static_cast<uint32_t>(static_cast<int64_t>(4294967296.0f * (fConst0 * static_cast<float>(input0[i0]))));
+            output0[i0] = static_cast<FAUSTFLOAT>(fSlow0_fast * ftbl0SineSIG0[(state->fRec1[1] >> 16)]);
             state->fRec1[1] = state->fRec1[0];
         }
     }
@@ -238,11 +232,8 @@ public:
         FAUSTFLOAT* output0 = out_samps;
         float fSlow0 = fConst0 * static_cast<float>(freq_samps[0]);
         for (int i0 = 0; i0 < BL; i0 = i0 + 1) {
-            state->iVec1[0] = 1;
-            float fTemp0 = ((1 - state->iVec1[1]) ? 0.0f : fSlow0 + state->fRec1[1]);
-            state->fRec1[0] = fTemp0 - std::floor(fTemp0);
-            output0[i0] = static_cast<FAUSTFLOAT>(static_cast<float>(input0[i0]) * ftbl0SineSIG0[std::max<int>(0, std::min<int>(static_cast<int>(65536.0f * state->fRec1[0]), 65535))]);
-            state->iVec1[1] = state->iVec1[0];
+            state->fRec1[0] = state->fRec1[1] + static_cast<uint32_t>(static_cast<int64_t>(4294967296.0f * (fSlow0)));
+            output0[i0] = static_cast<FAUSTFLOAT>(static_cast<float>(input0[i0]) * ftbl0SineSIG0[(state->fRec1[1] >> 16)]);
             state->fRec1[1] = state->fRec1[0];
         }
     }
@@ -260,11 +251,8 @@ public:
         for (int i0 = 0; i0 < BL; i0 = i0 + 1) {
             fSlow0_fast += fSlow0_incr;
             fSlow1_fast += fSlow1_incr;
-            state->iVec1[0] = 1;
-            float fTemp0 = ((1 - state->iVec1[1]) ? 0.0f : fSlow0_fast + state->fRec1[1]);
-            state->fRec1[0] = fTemp0 - std::floor(fTemp0);
-            output0[i0] = static_cast<FAUSTFLOAT>(fSlow1_fast * ftbl0SineSIG0[std::max<int>(0, std::min<int>(static_cast<int>(65536.0f * state->fRec1[0]), 65535))]);
-            state->iVec1[1] = state->iVec1[0];
+            state->fRec1[0] = state->fRec1[1] + static_cast<uint32_t>(static_cast<int64_t>(4294967296.0f * (fSlow0_fast)));
+            output0[i0] = static_cast<FAUSTFLOAT>(fSlow1_fast * ftbl0SineSIG0[(state->fRec1[1] >> 16)]);
             state->fRec1[1] = state->fRec1[0];
         }
     }
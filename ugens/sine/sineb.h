@@ -90,7 +90,7 @@ public:
     struct Sineb_state {
         int iVec1[2];
         FAUSTFLOAT fEntry0;
-        float fRec1[2];
+        uint32_t fRec1[2];  // fixed-point phase, 2^32 is one period
         FAUSTFLOAT fEntry1;
     };
     Vec<Sineb_state> states;
@@ -142,7 +142,7 @@ public:
                 states[i].iVec1[l2] = 0;
             }
             for (int l3 = 0; l3 < 2; l3 = l3 + 1) {
-                states[i].fRec1[l3] = 0.0f;
+                states[i].fRec1[l3] = 0;
             }
         }
     }
@@ -181,11 +181,8 @@ public:
         for (int i = 0; i < chans; i++) {
             float fSlow0 = fConst0 * static_cast<float>(freq_samps[0]);
             float fSlow1 = static_cast<float>(amp_samps[0]);
-            state->iVec1[0] = 1;
-            float fTemp0 = ((1 - state->iVec1[1]) ? 0.0f : fSlow0 + state->fRec1[1]);
-            state->fRec1[0] = fTemp0 - std::floor(fTemp0);
-            out_samps[0] = static_cast<FAUSTFLOAT>(fSlow1 * ftbl0SinebSIG0[std::max<int>(0, std::min<int>(static_cast<int>(65536.0f * state->fRec1[0]), 65535))]);
-            state->iVec1[1] = state->iVec1[0];
+            state->fRec1[0] = state->fRec1[1] + static_cast<uint32_t>(static_cast<int64_t>(4294967296.0f * (fSlow0)));
+            out_samps[0] = static_cast<FAUSTFLOAT>(fSlow1 * ftbl0SinebSIG0[(state->fRec1[1] >> 16)]);
             state->fRec1[1] = state->fRec1[0];
     
             state++;